@@ -0,0 +1,475 @@
+#include "Math/Matrix.hpp"
+#include "Math/AlignedVector.hpp"
+#include "Math/Transform.hpp"
+#include "Math/Frustum.hpp"
+#include <chrono>
+#include <fstream>
+#include <random>
+
+// Math microbenchmark suite, runs headless.
+//
+//   math_bench [--json <file>] [--filter <text>] [--quick]
+//
+// Correctness checks run first (specializations against the generic templates), then every case is
+// timed over working sets of several sizes. The math_bench_scalar target is the same suite built with
+// MATH_NO_SIMD, compare the JSON of both builds to see what the SIMD paths buy.
+
+#if defined(MATH_SIMD_AVX)
+static constexpr char const* s_simd_name = "avx";
+#elif defined(MATH_SIMD_SSE)
+static constexpr char const* s_simd_name = "sse";
+#else
+static constexpr char const* s_simd_name = "scalar";
+#endif
+
+// Working set sizes in elements: L1 resident, L2 resident, beyond L2
+static constexpr size_t s_sizes[] = { 16, 1024, 65536 };
+
+// Keep the optimizer from discarding benchmarked results
+template<class Ty>
+static void s_DoNotOptimize(Ty const& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile char sink;
+    sink = *reinterpret_cast<char const volatile*>(&value);
+#endif
+}
+
+// Run fun() iterations times and return the average nanoseconds per call
+template<class Fn>
+static double s_MeasureNs(size_t iterations, Fn&& fun)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+        fun(i);
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(iterations);
+}
+
+static Fmat4 s_RandomMatrix(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-10.0f, 10.0f);
+    Fmat4 res;
+    for (unsigned i = 0; i < 4; i++)
+        for (unsigned j = 0; j < 4; j++)
+            res[i][j] = dist(rng);
+    return res;
+}
+
+// Bit for bit, unless the compiler contracts a * b + c into FMA (-mfma with the default
+// -ffp-contract=fast). The generic templates and the intrinsics are then fused differently, so
+// values only agree to a few ulps of the largest element.
+template<class Ty>
+static bool s_Match(Ty const& value1, Ty const& value2)
+{
+    static_assert(sizeof(Ty) % sizeof(float) == 0);
+#if defined(__FMA__)
+    constexpr size_t count = sizeof(Ty) / sizeof(float);
+    float a[count], b[count], scale = 1.0f;
+    std::memcpy(a, &value1, sizeof(Ty));
+    std::memcpy(b, &value2, sizeof(Ty));
+    for (size_t i = 0; i < count; i++)
+        scale = std::max({ scale, std::abs(a[i]), std::abs(b[i]) });
+    for (size_t i = 0; i < count; i++)
+        if (std::abs(a[i] - b[i]) > scale * 1e-5f)
+            return false;
+    return true;
+#else
+    return std::memcmp(&value1, &value2, sizeof(Ty)) == 0;
+#endif
+}
+
+// Largest absolute deviation of mat * inv from the identity
+static float s_IdentityError(Fmat4 const& mat, Fmat4 const& inv)
+{
+    Fmat4 prod = operator*<float, float, 4, 4, 4>(mat, inv);
+    float err = 0.0f;
+    for (unsigned i = 0; i < 4; i++)
+        for (unsigned j = 0; j < 4; j++)
+            err = std::max(err, std::abs(prod[i][j] - (i == j ? 1.0f : 0.0f)));
+    return err;
+}
+
+// Camera at the origin, about a tenth of the random points fall inside
+static Frustum s_BenchFrustum()
+{
+    return ExtractFrustum(PerspectiveProjection(1.2f, 16.0f / 9.0f, 0.1f, 100.0f)
+        * LookAtView(Fvec3(0.0f), Fvec3(0.3f, -0.2f, -1.0f)));
+}
+
+// Random inputs shared by checks and timed cases
+struct BenchData
+{
+    std::vector<Fmat4> Matrices, Models;
+    std::vector<Fvec4> Vectors;
+    std::vector<Fvec3> Points, Directions, Translations, Axes, Scales;
+    std::vector<float> Angles;
+    std::vector<Fquat> Rotations;
+
+    BenchData(size_t count, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> dist(-100.0f, 100.0f), unit(-1.0f, 1.0f);
+        for (size_t i = 0; i < count; i++)
+        {
+            Matrices.push_back(s_RandomMatrix(rng));
+            Vectors.push_back(Matrices.back()[0]);
+            Points.push_back(Fvec3(dist(rng), dist(rng), dist(rng)));
+            Directions.push_back(Fvec3(unit(rng), unit(rng), unit(rng)));
+            Translations.push_back(Fvec3(dist(rng), dist(rng), dist(rng)));
+            Axes.push_back(Fvec3(unit(rng), unit(rng), unit(rng)));
+            Scales.push_back(Fvec3(unit(rng) + 2.0f, unit(rng) + 2.0f, unit(rng) + 2.0f));
+            Angles.push_back(unit(rng) * 3.14159f);
+            Rotations.push_back(AxisAngleQuat(Angles.back(), Axes.back()));
+            Models.push_back(TranslateModel(Translations.back()) * RotateModel(Angles.back(), Axes.back())
+                * ScaleModel(Scales.back()));
+        }
+    }
+};
+
+struct BenchResult
+{
+    std::string Name, Variant;
+    size_t Size;
+    double NsPerOp;
+};
+
+// Times cases and collects results, the first variant of a case at a size is the speedup baseline
+class BenchSuite
+{
+public:
+
+    BenchSuite(std::string filter, size_t target_ops)
+        : m_filter(std::move(filter)), m_target_ops(target_ops)
+    {
+    }
+
+    // fun() performs size operations per call
+    template<class Fn>
+    void Run(std::string const& name, std::string const& variant, size_t size, Fn&& fun)
+    {
+        if (!m_filter.empty() && name.find(m_filter) == std::string::npos)
+            return;
+
+        size_t reps = std::max<size_t>(1, m_target_ops / size);
+        fun();
+        double ns = s_MeasureNs(reps, [&](size_t) { fun(); }) / static_cast<double>(size);
+
+        double baseline = ns;
+        for (auto const& res : m_results)
+            if (res.Name == name && res.Size == size) {
+                baseline = res.NsPerOp;
+                break;
+            }
+
+        m_results.push_back({ name, variant, size, ns });
+        std::printf("%-24s %-18s %8zu %10.3f ns/op %10.2f Mops/s   x%.2f\n",
+            name.c_str(), variant.c_str(), size, ns, 1e3 / ns, baseline / ns);
+    }
+
+    void WriteJson(std::string const& path, size_t mismatches) const
+    {
+        std::ofstream file(path);
+        file << "{\n  \"simd\": \"" << s_simd_name << "\",\n  \"mismatches\": " << mismatches << ",\n  \"results\": [\n";
+        for (size_t i = 0; i < m_results.size(); i++)
+        {
+            auto const& res = m_results[i];
+            file << "    { \"name\": \"" << res.Name << "\", \"variant\": \"" << res.Variant << "\", \"size\": " << res.Size
+                 << ", \"ns_per_op\": " << res.NsPerOp << ", \"ops_per_sec\": " << 1e9 / res.NsPerOp << " }"
+                 << (i + 1 < m_results.size() ? ",\n" : "\n");
+        }
+        file << "  ]\n}\n";
+    }
+
+private:
+    std::string m_filter;
+    size_t m_target_ops;
+    std::vector<BenchResult> m_results;
+};
+
+// Specializations must agree with the generic templates, returns the number of failed checks
+static size_t s_Verify(BenchData const& data)
+{
+    size_t mismatches = 0, count = data.Matrices.size();
+    auto const& mats = data.Matrices;
+    auto const& vecs = data.Vectors;
+
+    // bit for bit without FMA contraction, same accumulation order
+    for (size_t i = 0; i < count; i++)
+    {
+        Fmat4 const& a = mats[i], & b = mats[(i + 1) % count];
+        if (!s_Match(a * b, operator*<float, float, 4, 4, 4>(a, b)))
+            ++mismatches;
+        if (!s_Match(a * vecs[i], operator*<float, float, 4, 4>(a, vecs[i])))
+            ++mismatches;
+
+        if (!s_Match(ComposeModel(data.Translations[i], data.Angles[i], data.Axes[i], data.Scales[i]), data.Models[i]))
+            ++mismatches;
+    }
+
+    // batch kernels against the per-element product
+    std::vector<Fvec3> expected(count), transformed(count);
+    for (size_t i = 0; i < count; i++)
+        expected[i] = mats[0] * (data.Points[i] & 1);
+    TransformPoints(mats[0], data.Points, transformed);
+    for (size_t i = 0; i < count; i++)
+        if (!s_Match(expected[i], transformed[i])) {
+            ++mismatches;
+            break;
+        }
+
+    // batched culling against the single bound tests
+    Frustum const frustum = s_BenchFrustum();
+    Fvec3Array centers(std::span<Fvec3 const>(data.Points)), extents(std::span<Fvec3 const>(data.Scales));
+    std::vector<float> radii(count);
+    for (size_t i = 0; i < count; i++)
+        radii[i] = data.Scales[i].x;
+    std::vector<uint32_t> visible(count);
+    size_t sphere_count = CullSpheres(frustum, centers, radii, visible), expected_index = 0;
+    for (size_t i = 0; i < count; i++)
+        if (IsSphereVisible(frustum, data.Points[i], radii[i]) && (expected_index >= sphere_count || visible[expected_index++] != i))
+            ++mismatches;
+    if (expected_index != sphere_count)
+        ++mismatches;
+    size_t box_count = CullBoxes(frustum, centers, extents, visible);
+    expected_index = 0;
+    for (size_t i = 0; i < count; i++)
+        if (IsBoxVisible(frustum, data.Points[i], data.Scales[i]) && (expected_index >= box_count || visible[expected_index++] != i))
+            ++mismatches;
+    if (expected_index != box_count)
+        ++mismatches;
+
+    // inverse precision, near singular random matrices say nothing about the implementation
+    constexpr float inverse_tolerance = 1e-3f;
+    float generic_err = 0.0f, special_err = 0.0f, affine_err = 0.0f, special_affine_err = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (std::abs(Determinant(mats[i])) > 100.0f) {
+            generic_err = std::max(generic_err, s_IdentityError(mats[i], Inverse<float>(mats[i])));
+            special_err = std::max(special_err, s_IdentityError(mats[i], Inverse(mats[i])));
+        }
+        affine_err = std::max(affine_err, s_IdentityError(data.Models[i], AffineInverse<float>(data.Models[i])));
+        special_affine_err = std::max(special_affine_err, s_IdentityError(data.Models[i], AffineInverse(data.Models[i])));
+    }
+    if (special_err > inverse_tolerance || affine_err > inverse_tolerance || special_affine_err > inverse_tolerance)
+        ++mismatches;
+
+    std::printf("Inverse max |M * inv - I| generic %g, specialized %g, affine generic %g, affine specialized %g\n",
+                generic_err, special_err, affine_err, special_affine_err);
+    std::printf("Mismatches: %zu\n\n", mismatches);
+    return mismatches;
+}
+
+static void s_RunSuite(BenchSuite& suite, BenchData const& data, size_t n)
+{
+    auto const& mats = data.Matrices;
+    auto const& vecs = data.Vectors;
+    std::vector<Fmat4> out_mats(n);
+    std::vector<Fvec4> out_vecs(n);
+    std::vector<Fvec3> out_points(n);
+
+    suite.Run("Fmat4 * Fmat4", "generic", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = operator*<float, float, 4, 4, 4>(mats[i], mats[n - 1 - i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+    suite.Run("Fmat4 * Fmat4", "specialized", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = mats[i] * mats[n - 1 - i];
+        s_DoNotOptimize(out_mats.data());
+    });
+
+    suite.Run("Fmat4 * Fvec4", "generic", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_vecs[i] = operator*<float, float, 4, 4>(mats[i], vecs[n - 1 - i]);
+        s_DoNotOptimize(out_vecs.data());
+    });
+    suite.Run("Fmat4 * Fvec4", "specialized", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_vecs[i] = mats[i] * vecs[n - 1 - i];
+        s_DoNotOptimize(out_vecs.data());
+    });
+
+    suite.Run("Inverse", "generic", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = Inverse<float>(data.Models[i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+    suite.Run("Inverse", "specialized", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = Inverse(data.Models[i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+    suite.Run("Inverse", "affine generic", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = AffineInverse<float>(data.Models[i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+    suite.Run("Inverse", "affine specialized", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = AffineInverse(data.Models[i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+
+    // vector math, MathVector against the aligned and structure-of-arrays variants
+    std::vector<AFvec3> aligned(data.Directions.begin(), data.Directions.end()), out_aligned(n);
+    Fvec3Array soa(std::span<Fvec3 const>(data.Directions.data(), n)), out_soa;
+
+    suite.Run("Normalize", "Fvec3", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_points[i] = Normalize(data.Directions[i]);
+        s_DoNotOptimize(out_points.data());
+    });
+    suite.Run("Normalize", "AFvec3", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_aligned[i] = Normalize(aligned[i]);
+        s_DoNotOptimize(out_aligned.data());
+    });
+    suite.Run("Normalize", "Fvec3Array", n, [&] {
+        out_soa = Normalize(soa);
+        s_DoNotOptimize(out_soa.Lane(0).data());
+    });
+
+    suite.Run("Cross", "Fvec3", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_points[i] = Cross(data.Directions[i], data.Points[i]);
+        s_DoNotOptimize(out_points.data());
+    });
+    suite.Run("Cross", "AFvec3", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_aligned[i] = Cross(aligned[i], aligned[n - 1 - i]);
+        s_DoNotOptimize(out_aligned.data());
+    });
+    suite.Run("Cross", "Fvec3Array", n, [&] {
+        out_soa = Cross(soa, soa);
+        s_DoNotOptimize(out_soa.Lane(0).data());
+    });
+
+    // matrix construction
+    suite.Run("RotateModel", "axis-angle", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = RotateModel(data.Angles[i], data.Axes[i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+    suite.Run("RotateModel", "quaternion", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = RotateModel(data.Rotations[i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+
+    suite.Run("Model T * R * S", "product", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = TranslateModel(data.Translations[i]) * RotateModel(data.Rotations[i]) * ScaleModel(data.Scales[i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+    suite.Run("Model T * R * S", "ComposeModel", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = ComposeModel(data.Translations[i], data.Rotations[i], data.Scales[i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+    suite.Run("Model T * R * S", "batched", n, [&] {
+        ComposeModel(std::span(data.Translations.data(), n), std::span(data.Rotations.data(), n),
+            std::span(data.Scales.data(), n), out_mats);
+        s_DoNotOptimize(out_mats.data());
+    });
+
+    suite.Run("LookAtView", "scalar", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = LookAtView(data.Translations[i], data.Directions[i]);
+        s_DoNotOptimize(out_mats.data());
+    });
+
+    suite.Run("PerspectiveProjection", "scalar", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_mats[i] = PerspectiveProjection(data.Angles[i] + 3.2f, 1.5f, 0.1f, 100.0f + data.Scales[i].x);
+        s_DoNotOptimize(out_mats.data());
+    });
+
+    // frustum culling, per-bound tests against the batched kernels
+    Frustum const frustum = s_BenchFrustum();
+    Fvec3Array centers(std::span<Fvec3 const>(data.Points.data(), n)), extents(std::span<Fvec3 const>(data.Scales.data(), n));
+    std::vector<float> radii(n);
+    for (size_t i = 0; i < n; i++)
+        radii[i] = data.Scales[i].x;
+    std::vector<uint32_t> visible(n);
+
+    suite.Run("Cull spheres", "loop", n, [&] {
+        size_t visible_count = 0;
+        for (size_t i = 0; i < n; i++)
+            if (IsSphereVisible(frustum, data.Points[i], radii[i]))
+                visible[visible_count++] = static_cast<uint32_t>(i);
+        s_DoNotOptimize(visible_count);
+    });
+    suite.Run("Cull spheres", "batched", n, [&] {
+        s_DoNotOptimize(CullSpheres(frustum, centers, radii, visible));
+    });
+    suite.Run("Cull boxes", "loop", n, [&] {
+        size_t visible_count = 0;
+        for (size_t i = 0; i < n; i++)
+            if (IsBoxVisible(frustum, data.Points[i], data.Scales[i]))
+                visible[visible_count++] = static_cast<uint32_t>(i);
+        s_DoNotOptimize(visible_count);
+    });
+    suite.Run("Cull boxes", "batched", n, [&] {
+        s_DoNotOptimize(CullBoxes(frustum, centers, extents, visible));
+    });
+
+    // batch transform of points, per-element loop against the bulk kernels
+    std::span<Fvec3 const> points(data.Points.data(), n);
+    Fvec3Array soa_points(points), soa_out(n);
+    Fmat4 const model = mats[0];
+
+    suite.Run("TransformPoints", "loop", n, [&] {
+        for (size_t i = 0; i < n; i++)
+            out_points[i] = model * (points[i] & 1);
+        s_DoNotOptimize(out_points.data());
+    });
+    suite.Run("TransformPoints", "AoS", n, [&] {
+        TransformPoints(model, points, out_points);
+        s_DoNotOptimize(out_points.data());
+    });
+    suite.Run("TransformPoints", "SoA", n, [&] {
+        TransformPoints(model, soa_points, soa_out);
+        s_DoNotOptimize(soa_out.Lane(0).data());
+    });
+    suite.Run("TransformPoints", "SoA threaded", n, [&] {
+        TransformPoints(model, soa_points, soa_out, 0);
+        s_DoNotOptimize(soa_out.Lane(0).data());
+    });
+}
+
+int main(int argc, char** argv)
+{
+    std::string json_path, filter;
+    size_t target_ops = 1 << 22;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc)
+            json_path = argv[++i];
+        else if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else if (arg == "--quick")
+            target_ops = 1 << 18;
+        else {
+            std::fprintf(stderr, "Usage: %s [--json <file>] [--filter <text>] [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(42);
+    BenchData data(s_sizes[std::size(s_sizes) - 1], rng);
+
+    std::printf("SIMD: %s\n", s_simd_name);
+    size_t mismatches = s_Verify(data);
+
+    BenchSuite suite(filter, target_ops);
+    for (size_t n : s_sizes)
+        s_RunSuite(suite, data, n);
+
+    if (!json_path.empty())
+        suite.WriteJson(json_path, mismatches);
+
+    return mismatches ? 1 : 0;
+}
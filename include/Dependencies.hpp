@@ -16,6 +16,21 @@
 #include <functional>
 #include <type_traits>
 #include <cmath>
+#include <span>
+#include <thread>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <optional>
+#include <deque>
+#include <filesystem>
+#include <chrono>
+#include <future>
+#include <condition_variable>
+#include <string_view>
 
 #define GRAPHICS_VALIDATION_LAYER "VK_LAYER_KHRONOS_validation"
 
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "Dependencies.hpp"
+
+// Power of two block suballocator over [0, size), only hands out offsets.
+// A range of 2^k bytes is always aligned to 2^k, so any power of two alignment up to the range size holds.
+class BuddyAllocator
+{
+public:
+
+    // size must be a power of two, requests are rounded up to at least min_size.
+    BuddyAllocator(VkDeviceSize size, VkDeviceSize min_size);
+
+    // Offset of a free range of at least size bytes aligned to alignment, nullopt when full.
+    NODISCARD std::optional<VkDeviceSize> Allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+    // Release a range returned by Allocate, merges with free buddies.
+    void Free(VkDeviceSize offset);
+
+    NODISCARD VkDeviceSize GetSize() const { return VkDeviceSize(1) << m_max_order; }
+
+    NODISCARD VkDeviceSize GetFreeBytes() const { return m_free_bytes; }
+
+    NODISCARD VkDeviceSize GetLargestFreeRange() const;
+
+    NODISCARD bool IsEmpty() const { return m_allocated.empty(); }
+
+private:
+
+    uint32_t m_min_order, m_max_order;
+    VkDeviceSize m_free_bytes;
+
+    // free range offsets per order, index order - m_min_order
+    std::vector<std::set<VkDeviceSize>> m_free;
+
+    // allocated range offset to its order
+    std::unordered_map<VkDeviceSize, uint32_t> m_allocated;
+};
+
+// Range of device memory owned by one buffer
+struct MemoryAllocation
+{
+    VkDeviceMemory Memory = VK_NULL_HANDLE;
+    VkDeviceSize Offset = 0;
+    VkDeviceSize Size = 0;
+
+    // Host address of Offset when the memory type is host visible, otherwise null
+    void* Mapped = nullptr;
+
+    uint32_t MemoryType = 0;
+
+    // Owning block of MemoryType, dedicated allocations own their VkDeviceMemory
+    uint32_t Block = 0;
+    bool Dedicated = false;
+};
+
+struct AllocatorStats
+{
+    // Live vkAllocateMemory objects, blocks plus dedicated allocations
+    uint32_t DeviceMemoryCount = 0;
+
+    // Live suballocations and dedicated allocations
+    uint32_t AllocationCount = 0;
+
+    // Bytes reserved from the driver
+    VkDeviceSize ReservedBytes = 0;
+
+    // Bytes requested by live allocations, the rest of the reserved bytes is rounding or free
+    VkDeviceSize RequestedBytes = 0;
+
+    // Bytes reserved from the device local, host visible memory type used for direct writes
+    VkDeviceSize DirectWriteBytes = 0;
+
+    // Free bytes inside blocks and the largest range one allocation could get, of any memory type
+    VkDeviceSize FreeBytes = 0;
+    VkDeviceSize LargestFreeRange = 0;
+
+    // Sum of the largest free range of every block
+    VkDeviceSize BlockLargestFreeBytes = 0;
+
+    // Share of the free bytes outside the largest free range of their block, 0 when every block's
+    // free memory is one range. Blocks are separate, so several untouched blocks are not fragmented.
+    NODISCARD float Fragmentation() const
+    {
+        return FreeBytes ? 1.0f - static_cast<float>(BlockLargestFreeBytes) / static_cast<float>(FreeBytes) : 0.0f;
+    }
+};
+
+// Device memory allocator, one list of large blocks per memory type with buddy suballocation.
+// Host visible blocks stay mapped for their whole lifetime. Thread safe.
+class DeviceAllocator
+{
+public:
+
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = VkDeviceSize(64) << 20;
+
+    DeviceAllocator(VkPhysicalDevice physical_device, VkDevice device, VkDeviceSize block_size = DEFAULT_BLOCK_SIZE);
+
+    ~DeviceAllocator();
+
+    DeviceAllocator(DeviceAllocator const&) = delete;
+    DeviceAllocator& operator=(DeviceAllocator const&) = delete;
+
+    // Allocate memory satisfying req from a type with all props flags.
+    NODISCARD MemoryAllocation Allocate(VkMemoryRequirements const& req, VkMemoryPropertyFlags props);
+
+    // Create a buffer and bind it to a new allocation.
+    NODISCARD std::pair<VkBuffer, MemoryAllocation>
+    CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props);
+
+    // Create a device local buffer. On UMA and resizable BAR devices it is placed in host visible
+    // device local memory while the direct write budget allows, the allocation is then mapped and can
+    // be written without staging.
+    NODISCARD std::pair<VkBuffer, MemoryAllocation>
+    CreateDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage);
+
+    void Free(MemoryAllocation const& allocation);
+
+    // Destroy a buffer from CreateBuffer and free its memory.
+    void DestroyBuffer(VkBuffer buffer, MemoryAllocation const& allocation);
+
+    // Index of the first memory type in filter with all flags.
+    NODISCARD uint32_t FindMemoryType(uint32_t filter, VkMemoryPropertyFlags flags) const;
+
+    NODISCARD VkPhysicalDeviceMemoryProperties const& GetMemoryProperties() const { return m_memory_properties; }
+
+    // Device local, host visible and coherent memory type, nullopt when the device has none
+    NODISCARD std::optional<uint32_t> GetDirectWriteMemoryType() const { return m_direct_type; }
+
+    // Cap on device memory reserved from the direct write type, defaults to half its heap so small BAR
+    // heaps are not exhausted.
+    void SetDirectWriteBudget(VkDeviceSize bytes);
+
+    NODISCARD VkDeviceSize GetDirectWriteBudget() const { return m_direct_budget; }
+
+    NODISCARD AllocatorStats GetStats() const;
+
+private:
+
+    struct MemoryBlock
+    {
+        VkDeviceMemory Memory;
+        void* Mapped;
+        BuddyAllocator Ranges;
+    };
+
+    VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32_t type, void** mapped);
+
+    // Allocate from a known memory type, m_mutex must be held. Returns an empty allocation instead of
+    // reserving device memory that would take the type past reserve_limit.
+    MemoryAllocation AllocateFromType(VkMemoryRequirements const& req, uint32_t type,
+                                      VkDeviceSize reserve_limit = std::numeric_limits<VkDeviceSize>::max());
+
+    VkBuffer CreateBufferHandle(VkDeviceSize size, VkBufferUsageFlags usage) const;
+
+    VkDevice m_device;
+    VkPhysicalDeviceMemoryProperties m_memory_properties;
+    uint32_t m_max_allocation_count;
+    VkDeviceSize m_block_sizes[VK_MAX_MEMORY_TYPES];
+
+    std::optional<uint32_t> m_direct_type;
+    VkDeviceSize m_direct_budget = 0;
+
+    mutable std::mutex m_mutex;
+
+    // null entries are released blocks whose index may be reused
+    std::vector<std::unique_ptr<MemoryBlock>> m_blocks[VK_MAX_MEMORY_TYPES];
+
+    uint32_t m_device_memory_count = 0;
+    uint32_t m_allocation_count = 0;
+    VkDeviceSize m_reserved_bytes = 0;
+    VkDeviceSize m_requested_bytes = 0;
+    VkDeviceSize m_type_reserved_bytes[VK_MAX_MEMORY_TYPES] = {};
+};
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Dependencies.hpp"
+#include "Graphics/Allocator.hpp"
+#include "Graphics/Upload.hpp"
 
 CLASS_DECLARE(GraphicsDevice);
 
@@ -12,42 +14,92 @@ public:
 
     ~VertexBuffer();
 
-    void MapData(const void* src);
+    // Upload size bytes, src may be reused on return. Buffers in host visible device memory are
+    // written directly and return a complete ticket, others go through the device staging ring.
+    UploadTicket MapData(const void* src);
+
+    // Write size bytes at offset, only the written ranges are uploaded by the next Flush.
+    // Host visible buffers are written in place.
+    void Update(VkDeviceSize offset, void const* src, VkDeviceSize size);
+
+    // Queue size bytes of src at offset into batch without a host copy, src must stay valid until the
+    // batch flushes. Host visible buffers are written in place.
+    void Write(UploadBatch& batch, VkDeviceSize offset, void const* src, VkDeviceSize size) const;
+
+    // Queue the ranges written since the last flush into batch.
+    void Flush(UploadBatch& batch);
+
+    UploadTicket Flush();
 
     NODISCARD VkBuffer GetBuffer() const { return m_buffer; }
 
     NODISCARD VkDeviceSize GetSize() const { return m_size; }
 
+    // Host address of the buffer when it lives in host visible device memory, otherwise null
+    NODISCARD void* GetMappedData() const { return m_memory.Mapped; }
+
 private:
 
     GraphicsDevice const& m_device;
 
     VkBuffer m_buffer;
-    VkDeviceMemory m_memory;
+    MemoryAllocation m_memory;
     VkDeviceSize m_size;
+    BufferShadow m_shadow;
 };
 
 class IndexBuffer
 {
 public:
 
-    IndexBuffer(GraphicsDevice const& device, VkDeviceSize size);
+    // count indices into vertex_count vertices, stored as the narrowest type that can address them
+    IndexBuffer(GraphicsDevice const& device, uint32_t count, uint32_t vertex_count);
+
+    IndexBuffer(GraphicsDevice const& device, uint32_t count, VkIndexType type);
 
     ~IndexBuffer();
 
-    void MapData(const unsigned* src);
+    // Narrowest index type for vertex_count vertices, uint8 only when the device enabled it.
+    NODISCARD static VkIndexType ChooseIndexType(GraphicsDevice const& device, uint32_t vertex_count);
+
+    // Upload count indices narrowed to the stored type, src may be reused on return.
+    UploadTicket MapData(const unsigned* src);
+
+    // Write count indices starting at index first, only the written ranges are uploaded by the next Flush.
+    // Host visible buffers are written in place.
+    void Update(VkDeviceSize first, unsigned const* src, VkDeviceSize count);
+
+    // Queue count indices starting at index first into batch without a host copy of the buffer. uint32
+    // indices are read from src when the batch flushes, narrowed ones are converted into bytes the batch
+    // owns. Host visible buffers are written in place.
+    void Write(UploadBatch& batch, VkDeviceSize first, unsigned const* src, VkDeviceSize count) const;
+
+    // Queue the ranges written since the last flush into batch.
+    void Flush(UploadBatch& batch);
+
+    UploadTicket Flush();
 
     NODISCARD VkBuffer GetBuffer() const { return m_buffer; }
 
     NODISCARD VkDeviceSize GetSize() const { return m_size; }
 
+    NODISCARD uint32_t GetCount() const { return m_count; }
+
+    NODISCARD VkIndexType GetIndexType() const { return m_index_type; }
+
+    // Host address of the buffer when it lives in host visible device memory, otherwise null
+    NODISCARD void* GetMappedData() const { return m_memory.Mapped; }
+
 private:
 
     GraphicsDevice const& m_device;
 
     VkBuffer m_buffer;
-    VkDeviceMemory m_memory;
+    MemoryAllocation m_memory;
     VkDeviceSize m_size;
+    uint32_t m_count;
+    VkIndexType m_index_type;
+    BufferShadow m_shadow;
 };
 
 class UniformBuffer 
@@ -59,6 +111,9 @@ public:
 	~UniformBuffer();
 
 	void Update(void const* src);
+
+	// Write size bytes of src at offset, the memory is coherent so nothing else is copied.
+	void Update(void const* src, VkDeviceSize offset, VkDeviceSize size);
     
 	NODISCARD VkBuffer GetBuffer() const { return m_buffer; }
 
@@ -69,7 +124,55 @@ private:
 	GraphicsDevice const& m_device;
 
 	VkBuffer m_buffer;
-	VkDeviceMemory m_memory;
+	MemoryAllocation m_memory;
 	VkDeviceSize m_size;
 	void* m_data;
 };
+
+// Per frame linear allocator of uniform data on one persistently mapped buffer, meant to back
+// dynamic uniform buffer bindings. Each frame in flight owns frame_size bytes, Push returns the
+// dynamic offset of the copied data.
+class UniformRing
+{
+public:
+
+    UniformRing(GraphicsDevice const& device, VkDeviceSize frame_size, uint32_t frame_count);
+
+    ~UniformRing();
+
+    UniformRing(UniformRing const&) = delete;
+    UniformRing& operator=(UniformRing const&) = delete;
+
+    // Restart allocation in the region of frame, the previous submission of frame must have finished.
+    void BeginFrame(uint32_t frame);
+
+    // Reserve size bytes aligned to minUniformBufferOffsetAlignment, returns the host address and dynamic offset.
+    std::pair<void*, uint32_t> Allocate(VkDeviceSize size);
+
+    // Copy size bytes of src into the current frame, returns the dynamic offset.
+    uint32_t Push(void const* src, VkDeviceSize size);
+
+    template<class Ty>
+    uint32_t Push(Ty const& value) { return Push(&value, sizeof(Ty)); }
+
+    NODISCARD VkBuffer GetBuffer() const { return m_buffer; }
+
+    NODISCARD VkDeviceSize GetAlignment() const { return m_alignment; }
+
+    NODISCARD VkDeviceSize GetFrameSize() const { return m_frame_size; }
+
+    // Bytes allocated in the current frame including alignment padding
+    NODISCARD VkDeviceSize GetUsedBytes() const { return m_offset - m_frame_begin; }
+
+private:
+
+    GraphicsDevice const& m_device;
+
+    VkBuffer m_buffer;
+    MemoryAllocation m_memory;
+    VkDeviceSize m_alignment, m_frame_size;
+    uint32_t m_frame_count;
+
+    // Allocation window of the current frame, [m_frame_begin, m_frame_begin + m_frame_size)
+    VkDeviceSize m_frame_begin = 0, m_offset = 0;
+};
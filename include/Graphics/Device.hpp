@@ -7,6 +7,14 @@ CLASS_DECLARE(DisplayWindow);
 CLASS_DECLARE(GraphicsPipeline);
 CLASS_DECLARE(VertexBuffer);
 CLASS_DECLARE(IndexBuffer);
+CLASS_DECLARE(DeviceAllocator);
+CLASS_DECLARE(StagingRing);
+CLASS_DECLARE(UploadBatch);
+CLASS_DECLARE(PipelineCache);
+CLASS_DECLARE(PipelineRegistry);
+CLASS_DECLARE(ShaderLibrary);
+
+struct Mesh;
 
 struct CommandQueue
 {
@@ -20,9 +28,13 @@ struct DrawCmdRecorder
     VkExtent2D Extent;
 
     void BindPipeline(GraphicsPipeline const& pipeline);
-    void BindVertexBuffer(VertexBuffer const& buffer);
+    void BindVertexBuffer(VertexBuffer const& buffer, uint32_t binding = 0, VkDeviceSize offset = 0);
+
+    // Bind buffers to consecutive bindings starting at first_binding, offsets default to 0
+    void BindVertexBuffers(uint32_t first_binding, std::span<VkBuffer const> buffers, std::span<VkDeviceSize const> offsets = {});
     void BindIndexBuffer(IndexBuffer const& buffer);
-	void BindDescriptorSets(GraphicsPipeline const& pipeline, int id);
+	// Bind every set of replica id, one dynamic offset per dynamic binding in set and binding order
+	void BindDescriptorSets(GraphicsPipeline const& pipeline, int id, std::span<uint32_t const> dynamic_offsets = {});
 
     void SetViewport(const VkViewport &viewport);
     void SetViewportDefault();
@@ -32,6 +44,9 @@ struct DrawCmdRecorder
     void Draw(uint32_t count, uint32_t instance);
     void DrawIndexed(uint32_t count, uint32_t instance);
 
+    // Draw a mesh of the bound GeometryPool buffers
+    void DrawIndexed(Mesh const& mesh, uint32_t instance);
+
     void EndRecord();
 };
 
@@ -39,7 +54,8 @@ class GraphicsDevice
 {
 public:
 
-    GraphicsDevice(GraphicsAPI const& api, DisplayWindow const& window);
+    // The pipeline cache is loaded from pipeline_cache_path and saved there on destruction
+    GraphicsDevice(GraphicsAPI const& api, DisplayWindow const& window, char const* pipeline_cache_path = "pipeline_cache.bin");
 
     ~GraphicsDevice();
 
@@ -67,6 +83,25 @@ public:
 
     NODISCARD CommandQueue GetPresentQueue() const { return m_present_queue; }
 
+    // Transfer only queue when the device has one, otherwise the graphics queue
+    NODISCARD CommandQueue GetTransferQueue() const { return m_transfer_queue; }
+
+    NODISCARD DeviceAllocator& GetAllocator() const { return *m_allocator; }
+
+    NODISCARD StagingRing& GetStagingRing() const { return *m_staging_ring; }
+
+    NODISCARD PipelineCache& GetPipelineCache() const { return *m_pipeline_cache; }
+
+    NODISCARD PipelineRegistry& GetPipelineRegistry() const { return *m_pipeline_registry; }
+
+    NODISCARD ShaderLibrary& GetShaderLibrary() const { return *m_shader_library; }
+
+    // Whether VK_EXT_index_type_uint8 is enabled
+    NODISCARD bool SupportsIndexTypeUint8() const { return m_index_type_uint8; }
+
+    // Empty batch uploading through GetStagingRing
+    NODISCARD UploadBatch CreateUploadBatch() const;
+
 private:
 
     void InitDeviceAndQueue(GraphicsAPI const& api, DisplayWindow const& window);
@@ -79,6 +114,15 @@ private:
 
     CommandQueue m_graphics_queue;
     CommandQueue m_present_queue;
+    CommandQueue m_transfer_queue;
+
+    bool m_index_type_uint8 = false;
+
+    std::unique_ptr<DeviceAllocator> m_allocator;
+    std::unique_ptr<StagingRing> m_staging_ring;
+    std::unique_ptr<PipelineCache> m_pipeline_cache;
+    std::unique_ptr<PipelineRegistry> m_pipeline_registry;
+    std::unique_ptr<ShaderLibrary> m_shader_library;
 
     VkSwapchainKHR m_swapchain;
     VkFormat m_swapchain_image_format;
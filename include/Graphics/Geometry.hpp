@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Dependencies.hpp"
+#include "Graphics/Buffer.hpp"
+
+CLASS_DECLARE(GraphicsDevice);
+
+// Range of a GeometryPool drawn with DrawCmdRecorder::DrawIndexed, indices are relative to VertexOffset
+struct Mesh
+{
+    uint32_t FirstIndex = 0;
+    uint32_t IndexCount = 0;
+    int32_t VertexOffset = 0;
+    uint32_t VertexCount = 0;
+};
+
+// Many meshes packed into one vertex buffer and one index buffer, so they draw with a single bind of each.
+// Ranges are first fit with neighbouring free ranges merged. Added meshes are staged from the caller's
+// memory through an UploadBatch, the pool keeps no host copy of its buffers.
+class GeometryPool
+{
+public:
+
+    // vertex_stride bytes per vertex, indices stored as index_type. Mesh local indices make uint16
+    // enough for any mesh below 65536 vertices regardless of the pool size.
+    GeometryPool(GraphicsDevice const& device, uint32_t vertex_stride, uint32_t vertex_capacity,
+                 uint32_t index_capacity, VkIndexType index_type = VK_INDEX_TYPE_UINT16);
+
+    GeometryPool(GeometryPool const&) = delete;
+    GeometryPool& operator=(GeometryPool const&) = delete;
+
+    // Queue a mesh into batch, vertices and indices must stay valid until the batch flushes. Throws when
+    // either buffer has no free range large enough or an index is out of the mesh's vertices.
+    NODISCARD Mesh Add(UploadBatch& batch, void const* vertices, uint32_t vertex_count,
+                       unsigned const* indices, uint32_t index_count);
+
+    // Release the ranges of mesh, draws still in flight must not use it anymore.
+    void Remove(Mesh const& mesh);
+
+    NODISCARD VertexBuffer const& GetVertexBuffer() const { return m_vertices; }
+
+    NODISCARD IndexBuffer const& GetIndexBuffer() const { return m_indices; }
+
+    NODISCARD uint32_t GetFreeVertexCount() const { return m_free_vertex_count; }
+
+    NODISCARD uint32_t GetFreeIndexCount() const { return m_free_index_count; }
+
+private:
+
+    uint32_t m_vertex_stride;
+
+    // most vertices one mesh can index with the pool's index type
+    uint32_t m_max_mesh_vertices;
+
+    VertexBuffer m_vertices;
+    IndexBuffer m_indices;
+
+    // free range offset to length, in vertices and indices
+    std::map<uint32_t, uint32_t> m_free_vertices, m_free_indices;
+    uint32_t m_free_vertex_count, m_free_index_count;
+};
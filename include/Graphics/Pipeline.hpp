@@ -8,13 +8,31 @@ CLASS_DECLARE(GraphicsDevice);
 struct VertexInputLayout
 {
     std::vector<VkVertexInputAttributeDescription> m_descs;
-    uint32_t m_stride = 0;
+    std::vector<VkVertexInputBindingDescription> m_bindings;
+
+    // Start the next binding, the following Add calls describe its attributes.
+    // Without it attributes go to binding 0 at vertex rate.
+    void AddBinding(VkVertexInputRate rate = VK_VERTEX_INPUT_RATE_VERTEX)
+    {
+        m_bindings.emplace_back(static_cast<uint32_t>(m_bindings.size()), 0, rate);
+    }
 
     void Add(int location, int size)
     {
+        if (m_bindings.empty())
+            AddBinding();
+        auto& binding = m_bindings.back();
         auto format = static_cast<VkFormat>(VK_FORMAT_R32_SFLOAT + (size - 1) * 3);
-        m_descs.emplace_back(location, 0, format, m_stride * sizeof(float));
-        m_stride += size;
+        m_descs.emplace_back(location, binding.binding, format, binding.stride);
+        binding.stride += size * sizeof(float);
+    }
+
+    // Column major matrix, one location per column, e.g. AddMatrix(location, 4, 4) for a per instance
+    // Fmat4 read as mat4, or 4 rows by 3 columns for a packed affine transform.
+    void AddMatrix(int location, int rows, int columns)
+    {
+        for (int i = 0; i < columns; i++)
+            Add(location + i, rows);
     }
 };
 
@@ -22,12 +40,52 @@ struct DescriptorSetLayout
 {
 	std::vector<VkDescriptorSetLayoutBinding> m_bindings;
 	uint32_t m_uniform_buffer_count = 0;
+	uint32_t m_dynamic_uniform_buffer_count = 0;
 
 	void AddUniformBuffer(int bind, VkShaderStageFlags stage)
 	{
 		m_bindings.emplace_back(bind, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, stage, nullptr);
 		++m_uniform_buffer_count;
 	}
+
+	// Uniform buffer whose offset is given when binding the set, see UniformRing
+	void AddDynamicUniformBuffer(int bind, VkShaderStageFlags stage)
+	{
+		m_bindings.emplace_back(bind, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, stage, nullptr);
+		++m_dynamic_uniform_buffer_count;
+	}
+};
+
+// Values of a stage's layout(constant_id = id) constants, applied when the pipeline is created so the
+// driver can fold them. bool is stored as VkBool32.
+struct SpecializationConstants
+{
+	std::vector<VkSpecializationMapEntry> m_entries;
+	std::vector<unsigned char> m_data;
+
+	template<class Ty>
+	void Set(uint32_t id, Ty value)
+	{
+		static_assert(std::is_same_v<Ty, bool> || std::is_same_v<Ty, int32_t> || std::is_same_v<Ty, uint32_t>
+			|| std::is_same_v<Ty, int64_t> || std::is_same_v<Ty, uint64_t> || std::is_same_v<Ty, float>
+			|| std::is_same_v<Ty, double>, "not a SPIR-V scalar constant type");
+
+		using Stored = std::conditional_t<std::is_same_v<Ty, bool>, VkBool32, Ty>;
+		Stored stored = static_cast<Stored>(value);
+
+		auto it = std::find_if(m_entries.begin(), m_entries.end(), [id](auto const& entry) { return entry.constantID == id; });
+		if (it == m_entries.end() || it->size != sizeof(Stored)) {
+			if (it == m_entries.end())
+				it = m_entries.emplace(m_entries.end());
+			it->constantID = id;
+			it->offset = static_cast<uint32_t>(m_data.size());
+			it->size = sizeof(Stored);
+			m_data.resize(m_data.size() + sizeof(Stored));
+		}
+		std::memcpy(m_data.data() + it->offset, &stored, sizeof(Stored));
+	}
+
+	NODISCARD bool Empty() const { return m_entries.empty(); }
 };
 
 class GraphicsPipeline
@@ -37,11 +95,14 @@ public:
     struct CreateInfo
     {
         GraphicsDevice const* Device;
+        // Shader names resolved by the device ShaderLibrary, archive names or SPIR-V file paths
         char const* Vertex;
         char const* Fragment;
         VertexInputLayout Input;
 		DescriptorSetLayout Descriptors[4];
 		uint32_t DescriptorSetsMultiplier = 1;
+		SpecializationConstants VertexConstants;
+		SpecializationConstants FragmentConstants;
     };
 
     explicit GraphicsPipeline(CreateInfo const& info);
@@ -52,17 +113,77 @@ public:
 
 	NODISCARD VkPipelineLayout GetLayout() const { return m_pipeline_layout; }
 
-	void WriteDescriptor(int sid, int rid, VkBuffer buffer, size_t size);
+	// Point binding of set sid in replica rid at buffer. Dynamic bindings get size as the range read
+	// past each dynamic offset.
+	void WriteDescriptor(int sid, int rid, VkBuffer buffer, size_t size, uint32_t binding = 0);
+
+	// First of the GetDescriptorSetCount sets of replica id
+	VkDescriptorSet const& GetDescriptorSets(int id) const { return m_descriptor_sets[id * m_descriptor_set_layouts.size()]; }
 
-	VkDescriptorSet const& GetDescriptorSets(int id) const { return m_descriptor_sets[id]; }
+	NODISCARD uint32_t GetDescriptorSetCount() const { return static_cast<uint32_t>(m_descriptor_set_layouts.size()); }
 
 private:
 
+    friend class PipelineRegistry;
+
+    // VkPipeline shared by the pipelines PipelineRegistry made from equal state
+    struct SharedPipeline
+    {
+        VkDevice Device;
+        VkPipeline Pipeline;
+
+        SharedPipeline(VkDevice device, VkPipeline pipeline) : Device(device), Pipeline(pipeline) {}
+        ~SharedPipeline() { vkDestroyPipeline(Device, Pipeline, nullptr); }
+
+        SharedPipeline(SharedPipeline const&) = delete;
+        SharedPipeline& operator=(SharedPipeline const&) = delete;
+    };
+
+    // Uses *shared when set, otherwise creates the pipeline and stores it there
+    GraphicsPipeline(CreateInfo const& info, std::shared_ptr<SharedPipeline>* shared);
+
+    static VkPipeline CreatePipeline(CreateInfo const& info, VkPipelineLayout layout);
+
     GraphicsDevice const& m_device;
     VkPipeline m_pipeline;
     VkPipelineLayout m_pipeline_layout;
+    std::shared_ptr<SharedPipeline> m_shared_pipeline;
 
 	std::vector<VkDescriptorSetLayout> m_descriptor_set_layouts;
+	std::vector<std::vector<VkDescriptorSetLayoutBinding>> m_descriptor_bindings;
 	VkDescriptorPool m_descriptor_pool;
 	std::vector<VkDescriptorSet> m_descriptor_sets;
 };
+
+// Worker threads building pipelines in parallel through the device pipeline cache.
+// Everything a CreateInfo points to (device, shader paths) must outlive its future.
+class PipelineCompiler
+{
+public:
+
+    explicit PipelineCompiler(uint32_t thread_count = std::thread::hardware_concurrency());
+
+    // Finishes the queued pipelines.
+    ~PipelineCompiler();
+
+    PipelineCompiler(PipelineCompiler const&) = delete;
+    PipelineCompiler& operator=(PipelineCompiler const&) = delete;
+
+    // Queue a pipeline, creation errors are rethrown by the future's get.
+    NODISCARD std::future<std::unique_ptr<GraphicsPipeline>> Submit(GraphicsPipeline::CreateInfo const& info);
+
+    NODISCARD std::vector<std::future<std::unique_ptr<GraphicsPipeline>>> Submit(std::span<GraphicsPipeline::CreateInfo const> infos);
+
+    NODISCARD uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+private:
+
+    void Work();
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::packaged_task<std::unique_ptr<GraphicsPipeline>()>> m_tasks;
+    bool m_stop = false;
+};
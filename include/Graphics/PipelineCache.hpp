@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Dependencies.hpp"
+
+struct PipelineCacheStats
+{
+    // Bytes of valid cache data loaded at startup, 0 on a cold start
+    size_t LoadedBytes = 0;
+
+    uint32_t PipelineCount = 0;
+
+    // Pipelines the driver reported as found in the cache, needs creation feedback (Vulkan 1.3)
+    uint32_t HitCount = 0;
+
+    // Wall time spent in vkCreateGraphicsPipelines, in total and for the cache hits, summed over threads
+    double CreateMilliseconds = 0;
+    double HitMilliseconds = 0;
+};
+
+// Device pipeline cache persisted in a file. The file is only used when its header matches the
+// vendor, device and pipeline cache UUID of the physical device, it is rewritten through a temporary
+// file and a rename so a crash never leaves a torn cache behind. On POSIX systems the file and its
+// directory are fsynced, which covers system crashes and power loss too, elsewhere only process crashes.
+// Thread safe, Vulkan synchronizes access to the cache itself.
+class PipelineCache
+{
+public:
+
+    PipelineCache(VkPhysicalDevice physical_device, VkDevice device, std::string path);
+
+    // Saves the cache.
+    ~PipelineCache();
+
+    PipelineCache(PipelineCache const&) = delete;
+    PipelineCache& operator=(PipelineCache const&) = delete;
+
+    // Write the cache data to the file, false when it could not be written.
+    bool Save() const;
+
+    // Create a graphics pipeline through the cache and record its creation cost.
+    NODISCARD VkPipeline CreateGraphicsPipeline(VkGraphicsPipelineCreateInfo const& info);
+
+    NODISCARD VkPipelineCache GetCache() const { return m_cache; }
+
+    NODISCARD PipelineCacheStats GetStats() const;
+
+private:
+
+    VkDevice m_device;
+    VkPipelineCache m_cache;
+    std::string m_path;
+
+    // creation feedback is core since Vulkan 1.3
+    bool m_feedback;
+
+    mutable std::mutex m_stats_mutex;
+    PipelineCacheStats m_stats;
+};
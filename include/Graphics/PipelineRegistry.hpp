@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Dependencies.hpp"
+#include "Graphics/Pipeline.hpp"
+
+CLASS_DECLARE(GraphicsDevice);
+
+// Device wide deduplication of pipeline objects.
+// Descriptor set layouts and pipeline layouts are shared by every GraphicsPipeline and live until the
+// device is destroyed. Pipelines requested through GetPipeline share one VkPipeline per distinct state,
+// each caller still gets its own descriptor pool and sets. Thread safe.
+class PipelineRegistry
+{
+public:
+
+    explicit PipelineRegistry(GraphicsDevice const& device);
+
+    ~PipelineRegistry();
+
+    PipelineRegistry(PipelineRegistry const&) = delete;
+    PipelineRegistry& operator=(PipelineRegistry const&) = delete;
+
+    // Layout with the same bindings, in any order, as an earlier call or a new one.
+    NODISCARD VkDescriptorSetLayout GetSetLayout(std::span<VkDescriptorSetLayoutBinding const> bindings);
+
+    NODISCARD VkPipelineLayout GetPipelineLayout(std::span<VkDescriptorSetLayout const> set_layouts);
+
+    // Pipeline object sharing the VkPipeline of earlier requests with the same state, created on a miss.
+    NODISCARD std::unique_ptr<GraphicsPipeline> GetPipeline(GraphicsPipeline::CreateInfo const& info);
+
+    // Hash of everything that defines the VkPipeline: shader SPIR-V, vertex input, descriptor layouts,
+    // specialization constants and render pass. Raster and blend state are fixed by GraphicsPipeline.
+    NODISCARD uint64_t Hash(GraphicsPipeline::CreateInfo const& info);
+
+    // Destroy VkPipelines no GraphicsPipeline uses anymore.
+    void Trim();
+
+    NODISCARD size_t GetPipelineCount() const;
+
+    NODISCARD size_t GetSetLayoutCount() const;
+
+private:
+
+    // Serialized pipeline state, shaders are represented by their SPIR-V hash
+    std::string StateKey(GraphicsPipeline::CreateInfo const& info);
+
+    uint64_t ShaderHash(char const* name);
+
+    GraphicsDevice const& m_device;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, VkDescriptorSetLayout> m_set_layouts;
+    std::unordered_map<std::string, VkPipelineLayout> m_pipeline_layouts;
+    std::unordered_map<std::string, std::shared_ptr<GraphicsPipeline::SharedPipeline>> m_pipelines;
+    std::unordered_map<std::string, uint64_t> m_shader_hashes;
+};
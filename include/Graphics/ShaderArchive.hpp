@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Dependencies.hpp"
+#include "Graphics/ShaderArchiveFormat.hpp"
+
+// Read only view of a packed shader archive (see ShaderArchiveFormat.hpp).
+// The file is memory mapped where mmap exists and read into one aligned buffer elsewhere, so the
+// returned SPIR-V is never copied per shader and can be passed as pCode directly.
+class ShaderArchive
+{
+public:
+
+    // Throws when the file is missing or malformed.
+    explicit ShaderArchive(char const* path);
+
+    ~ShaderArchive();
+
+    ShaderArchive(ShaderArchive const&) = delete;
+    ShaderArchive& operator=(ShaderArchive const&) = delete;
+
+    // SPIR-V of name, empty when the archive has no such shader.
+    NODISCARD std::span<uint32_t const> Find(std::string_view name) const;
+
+    NODISCARD uint32_t GetCount() const { return static_cast<uint32_t>(m_entries.size()); }
+
+private:
+
+    void const* m_data = nullptr;
+    size_t m_size = 0;
+
+    // fallback storage when the file is not mapped
+    std::unique_ptr<uint32_t[]> m_buffer;
+
+    std::span<ShaderArchiveEntry const> m_entries;
+};
+
+// Device wide shader modules created once per name.
+// Names are looked up in the mounted archives first, in mount order, and are otherwise read as SPIR-V
+// file paths. Thread safe.
+class ShaderLibrary
+{
+public:
+
+    explicit ShaderLibrary(VkDevice device);
+
+    ~ShaderLibrary();
+
+    ShaderLibrary(ShaderLibrary const&) = delete;
+    ShaderLibrary& operator=(ShaderLibrary const&) = delete;
+
+    // Open an archive and add its shaders to the lookup.
+    void Mount(char const* path);
+
+    // SPIR-V of name, stays valid for the library's lifetime. Throws, naming the shader, when it is not
+    // found or its file cannot be read.
+    NODISCARD std::span<uint32_t const> GetCode(std::string const& name);
+
+    // Module of name, created on first use and destroyed with the library. Threads racing on the first
+    // use may each create one, a single module is kept.
+    NODISCARD VkShaderModule GetModule(std::string const& name);
+
+    NODISCARD size_t GetModuleCount() const;
+
+private:
+
+    VkDevice m_device;
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<ShaderArchive>> m_archives;
+
+    // SPIR-V read from loose files
+    std::unordered_map<std::string, std::vector<uint32_t>> m_files;
+
+    std::unordered_map<std::string, VkShaderModule> m_modules;
+};
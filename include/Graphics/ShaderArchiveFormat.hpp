@@ -0,0 +1,34 @@
+#pragma once
+
+// Layout of a packed shader archive, shared with the shader_pack build tool so it only needs the
+// standard library. Little endian, written and read as raw structs:
+//
+//   ShaderArchiveHeader
+//   ShaderArchiveEntry[Count]
+//   SPIR-V blobs, each at an offset aligned to SHADER_ARCHIVE_ALIGNMENT
+
+#include <cstdint>
+
+inline constexpr char SHADER_ARCHIVE_MAGIC[4] = { 'S', 'P', 'V', 'A' };
+inline constexpr uint32_t SHADER_ARCHIVE_VERSION = 1;
+inline constexpr uint64_t SHADER_ARCHIVE_ALIGNMENT = 16;
+
+struct ShaderArchiveHeader
+{
+    char Magic[4];
+    uint32_t Version;
+    uint32_t Count;
+    uint32_t Reserved;
+};
+
+struct ShaderArchiveEntry
+{
+    // Null terminated, e.g. "shader.vert" for shader.vert.spv
+    char Name[48];
+
+    // Byte range of the SPIR-V from the start of the archive
+    uint64_t Offset;
+    uint64_t Size;
+};
+
+static_assert(sizeof(ShaderArchiveHeader) == 16 && sizeof(ShaderArchiveEntry) == 64);
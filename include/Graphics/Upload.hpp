@@ -0,0 +1,199 @@
+#pragma once
+
+#include "Dependencies.hpp"
+#include "Graphics/Allocator.hpp"
+
+CLASS_DECLARE(GraphicsDevice);
+CLASS_DECLARE(StagingRing);
+CLASS_DECLARE(VertexBuffer);
+CLASS_DECLARE(IndexBuffer);
+
+// Write of Size bytes from Src to Dst at DstOffset, made visible to DstStage / DstAccess
+struct UploadWrite
+{
+    VkBuffer Dst;
+    VkDeviceSize DstOffset;
+    void const* Src;
+    VkDeviceSize Size;
+    VkPipelineStageFlags DstStage;
+    VkAccessFlags DstAccess;
+};
+
+// Completion token of an upload, default constructed tickets are always complete
+class UploadTicket
+{
+public:
+
+    UploadTicket() = default;
+
+    // True once the data can be read by work submitted to the graphics queue.
+    NODISCARD bool IsComplete() const;
+
+    // Block until IsComplete.
+    void Wait() const;
+
+    NODISCARD uint64_t GetValue() const { return m_value; }
+
+private:
+
+    friend class StagingRing;
+
+    UploadTicket(StagingRing const* ring, uint64_t value) : m_ring(ring), m_value(value) {}
+
+    StagingRing const* m_ring = nullptr;
+    uint64_t m_value = 0;
+};
+
+// Persistently mapped host visible ring used to stage buffer uploads.
+// Copies run on the transfer queue when the device has a transfer only family, ownership of the
+// written range is then released there and acquired on the graphics queue.
+// Two timelines track an upload: the copy timeline frees its ring space once the copy is done,
+// the ready timeline completes its ticket once the graphics queue owns the data.
+// Not thread safe, also submits to the graphics queue.
+class StagingRing
+{
+public:
+
+    static constexpr VkDeviceSize DEFAULT_SIZE = VkDeviceSize(32) << 20;
+
+    explicit StagingRing(GraphicsDevice const& device, VkDeviceSize size = DEFAULT_SIZE);
+
+    ~StagingRing();
+
+    StagingRing(StagingRing const&) = delete;
+    StagingRing& operator=(StagingRing const&) = delete;
+
+    // Pack all writes into one staging range and copy them with one command buffer and one submit.
+    // Sources may be reused on return, writes to the same buffer must not overlap. Batches larger than
+    // the ring get a temporary staging buffer instead. On a separate transfer queue the copies are not
+    // ordered against draws still reading the destinations, buffers read by frames in flight should only
+    // be rewritten after those frames finished.
+    UploadTicket Upload(std::span<UploadWrite const> writes);
+
+    // Block until the upload with ticket value has completed.
+    void Wait(uint64_t value) const;
+
+    NODISCARD bool IsComplete(uint64_t value) const;
+
+    NODISCARD VkDeviceSize GetSize() const { return m_size; }
+
+    // Whether copies run on a separate transfer queue family
+    NODISCARD bool IsAsync() const { return m_acquire_pool != VK_NULL_HANDLE; }
+
+private:
+
+    struct InFlight
+    {
+        uint64_t Value;
+
+        // Ring position released once Value is reached
+        VkDeviceSize End;
+
+        VkCommandBuffer Cmd;
+
+        // Temporary staging buffer of an oversized upload, otherwise null
+        VkBuffer Buffer;
+        MemoryAllocation Memory;
+    };
+
+    struct Acquire
+    {
+        uint64_t Value;
+        VkCommandBuffer Cmd;
+    };
+
+    // Reserve size bytes, waits for older copies when the ring is full. Returns the ring offset.
+    VkDeviceSize Reserve(VkDeviceSize size);
+
+    // Release ring space and command buffers of completed uploads.
+    void Reclaim();
+
+    VkCommandBuffer NextCmd(VkCommandPool pool, std::vector<VkCommandBuffer>& free_cmds);
+
+    GraphicsDevice const& m_device;
+
+    VkBuffer m_buffer;
+    MemoryAllocation m_memory;
+    VkDeviceSize m_size;
+
+    // Monotonic positions, m_head % m_size is the next write, nothing before m_tail is in flight
+    VkDeviceSize m_head = 0, m_tail = 0;
+
+    // Copies on the transfer family, ownership acquires on the graphics family (null when they match)
+    VkCommandPool m_pool, m_acquire_pool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> m_free_cmds, m_free_acquire_cmds;
+
+    VkSemaphore m_copy_timeline, m_ready_timeline;
+    uint64_t m_submitted = 0;
+
+    std::deque<InFlight> m_in_flight;
+    std::deque<Acquire> m_acquires;
+};
+
+// Collects buffer writes and uploads them together through the device staging ring
+class UploadBatch
+{
+public:
+
+    explicit UploadBatch(GraphicsDevice const& device);
+
+    // Queue a write, src must stay valid until Flush.
+    void Write(VkBuffer dst, VkDeviceSize dst_offset, void const* src, VkDeviceSize size,
+               VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+
+    // Queue a write of bytes, which the batch keeps until Flush.
+    void Write(VkBuffer dst, VkDeviceSize dst_offset, std::vector<char>&& bytes,
+               VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+
+    // Queue a write of the whole buffer, buffers in host visible device memory are written immediately.
+    void Write(VertexBuffer const& dst, void const* src);
+
+    // Indices are narrowed to the buffer's type, narrowed buffers then stage from their shadow.
+    void Write(IndexBuffer& dst, unsigned const* src);
+
+    // Upload every queued write with one submit and clear the batch.
+    UploadTicket Flush();
+
+    NODISCARD size_t GetWriteCount() const { return m_writes.size(); }
+
+    NODISCARD VkDeviceSize GetByteCount() const { return m_bytes; }
+
+private:
+
+    GraphicsDevice const& m_device;
+
+    std::vector<UploadWrite> m_writes;
+    VkDeviceSize m_bytes = 0;
+
+    // sources handed over by Write, moving a vector keeps its data address
+    std::vector<std::vector<char>> m_owned;
+};
+
+// Byte ranges of a device local buffer written since the last flush, only their contents are kept on the host.
+// Touching or overlapping ranges merge, so a flush uploads one copy region per disjoint range.
+class BufferShadow
+{
+public:
+
+    // Copy size bytes of src to offset of a buffer_size byte buffer.
+    void Write(VkDeviceSize offset, void const* src, VkDeviceSize size, VkDeviceSize buffer_size);
+
+    // Mark size bytes at offset dirty and return their address for the caller to fill, valid until the
+    // next call. Null when size is 0.
+    NODISCARD void* MarkDirty(VkDeviceSize offset, VkDeviceSize size, VkDeviceSize buffer_size);
+
+    // Hand every dirty range to batch and mark them clean, the shadow keeps no bytes afterwards.
+    void Flush(UploadBatch& batch, VkBuffer dst, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access);
+
+    // Drop dirty ranges, e.g. after the whole buffer was rewritten.
+    void Discard() { m_dirty.clear(); }
+
+    NODISCARD bool IsDirty() const { return !m_dirty.empty(); }
+
+    NODISCARD size_t GetDirtyRangeCount() const { return m_dirty.size(); }
+
+private:
+
+    // dirty range begin to its bytes, disjoint and not touching
+    std::map<VkDeviceSize, std::vector<char>> m_dirty;
+};
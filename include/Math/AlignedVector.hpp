@@ -0,0 +1,366 @@
+#pragma once
+
+#include "Dependencies.hpp"
+#include "Math/Vector.hpp"
+#include "Math/Simd.hpp"
+
+// Mathematical vectors with 16 byte aligned storage, loaded into one SIMD register.
+// Opt-in counterpart of MathVector for float 3D and 4D vectors.
+template<class Ty, unsigned Dim>
+class MathAlignedVector;
+
+// 3D aligned vector variation (x, y, z), the fourth lane is padding with unspecified value
+template<>
+class alignas(16) MathAlignedVector<float, 3>
+{
+public:
+
+	float x, y, z;
+
+	constexpr MathAlignedVector() noexcept = default;
+
+	template<class ScTy> requires std::is_arithmetic_v<ScTy>
+	explicit constexpr MathAlignedVector(ScTy value) noexcept
+		: x(static_cast<float>(value)), y(static_cast<float>(value)), z(static_cast<float>(value)), m_pad(0)
+	{
+	}
+
+	constexpr MathAlignedVector(auto x, auto y, auto z) noexcept
+		: x(static_cast<float>(x)), y(static_cast<float>(y)), z(static_cast<float>(z)), m_pad(0)
+	{
+	}
+
+	template<class Ty2, unsigned Dim2> requires (Dim2 >= 3)
+	constexpr MathAlignedVector(MathVector<Ty2, Dim2> const& vec) noexcept
+		: x(static_cast<float>(vec[0])), y(static_cast<float>(vec[1])), z(static_cast<float>(vec[2])), m_pad(0)
+	{
+	}
+
+	constexpr operator MathVector<float, 3>() const noexcept
+	{
+		return { x, y, z };
+	}
+
+	constexpr float& operator[](unsigned i)
+	{
+		return i == 2 ? z : (i ? y : x);
+	}
+
+	constexpr float const& operator[](unsigned i) const
+	{
+		return i == 2 ? z : (i ? y : x);
+	}
+
+#if defined(MATH_SIMD_SSE)
+
+	// Construct from a register, all four lanes are stored.
+	explicit MathAlignedVector(__m128 reg) noexcept
+	{
+		_mm_store_ps(&x, reg);
+	}
+
+	// Load into a register, the fourth lane is unspecified.
+	NODISCARD __m128 Load() const
+	{
+		return _mm_load_ps(&x);
+	}
+
+#endif
+
+	float Norm() const;
+
+	MathAlignedVector& operator+=(MathAlignedVector const& vec);
+
+	MathAlignedVector& operator-=(MathAlignedVector const& vec);
+
+	MathAlignedVector& operator*=(float scale);
+
+private:
+	float m_pad;
+};
+
+// 4D aligned vector variation (x, y, z, w)
+template<>
+class alignas(16) MathAlignedVector<float, 4>
+{
+public:
+
+	float x, y, z, w;
+
+	constexpr MathAlignedVector() noexcept = default;
+
+	template<class ScTy> requires std::is_arithmetic_v<ScTy>
+	explicit constexpr MathAlignedVector(ScTy value) noexcept
+		: x(static_cast<float>(value)), y(static_cast<float>(value)), z(static_cast<float>(value)), w(static_cast<float>(value))
+	{
+	}
+
+	constexpr MathAlignedVector(auto x, auto y, auto z, auto w) noexcept
+		: x(static_cast<float>(x)), y(static_cast<float>(y)), z(static_cast<float>(z)), w(static_cast<float>(w))
+	{
+	}
+
+	template<class Ty2, unsigned Dim2> requires (Dim2 >= 4)
+	constexpr MathAlignedVector(MathVector<Ty2, Dim2> const& vec) noexcept
+		: x(static_cast<float>(vec[0])), y(static_cast<float>(vec[1])), z(static_cast<float>(vec[2])), w(static_cast<float>(vec[3]))
+	{
+	}
+
+	constexpr operator MathVector<float, 4>() const noexcept
+	{
+		return { x, y, z, w };
+	}
+
+	constexpr float& operator[](unsigned i)
+	{
+		return i == 3 ? w : (i == 2 ? z : (i ? y : x));
+	}
+
+	constexpr float const& operator[](unsigned i) const
+	{
+		return i == 3 ? w : (i == 2 ? z : (i ? y : x));
+	}
+
+#if defined(MATH_SIMD_SSE)
+
+	// Construct from a register.
+	explicit MathAlignedVector(__m128 reg) noexcept
+	{
+		_mm_store_ps(&x, reg);
+	}
+
+	// Load into a register.
+	NODISCARD __m128 Load() const
+	{
+		return _mm_load_ps(&x);
+	}
+
+#endif
+
+	float Norm() const;
+
+	MathAlignedVector& operator+=(MathAlignedVector const& vec);
+
+	MathAlignedVector& operator-=(MathAlignedVector const& vec);
+
+	MathAlignedVector& operator*=(float scale);
+};
+
+// -------------------- Typedefs ---------------------- //
+
+using AFvec3 = MathAlignedVector<float, 3>;
+using AFvec4 = MathAlignedVector<float, 4>;
+
+static_assert(sizeof(AFvec3) == 16 && alignof(AFvec3) == 16);
+static_assert(sizeof(AFvec4) == 16 && alignof(AFvec4) == 16);
+
+// ------------------------------------ Functions ------------------------------------ //
+
+#if defined(MATH_SIMD_SSE)
+
+// Sum the first Dim lanes of a register in index order, result in the lowest lane
+template<unsigned Dim>
+inline __m128 SimdHorizontalSum(__m128 reg)
+{
+	__m128 sum = _mm_add_ss(reg, _mm_shuffle_ps(reg, reg, 0x55));
+	sum = _mm_add_ss(sum, _mm_movehl_ps(reg, reg));
+	if constexpr (Dim == 4)
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(reg, reg, 0xFF));
+	return sum;
+}
+
+#endif
+
+// Returns true if 2 aligned vectors are equal
+template<unsigned Dim>
+inline bool operator==(MathAlignedVector<float, Dim> const& vec1, MathAlignedVector<float, Dim> const& vec2)
+{
+#if defined(MATH_SIMD_SSE)
+	int mask = _mm_movemask_ps(_mm_cmpeq_ps(vec1.Load(), vec2.Load()));
+	return (mask & ((1 << Dim) - 1)) == (1 << Dim) - 1;
+#else
+	for (unsigned i = 0; i < Dim; i++)
+		if (vec1[i] != vec2[i])
+			return false;
+	return true;
+#endif
+}
+
+// Addition operation bewteen 2 aligned vectors
+template<unsigned Dim>
+inline auto operator+(MathAlignedVector<float, Dim> const& vec1, MathAlignedVector<float, Dim> const& vec2)
+{
+#if defined(MATH_SIMD_SSE)
+	return MathAlignedVector<float, Dim>(_mm_add_ps(vec1.Load(), vec2.Load()));
+#else
+	MathAlignedVector<float, Dim> res(0.0f);
+	for (unsigned i = 0; i < Dim; i++)
+		res[i] = vec1[i] + vec2[i];
+	return res;
+#endif
+}
+
+// Subtraction operation bewteen 2 aligned vectors
+template<unsigned Dim>
+inline auto operator-(MathAlignedVector<float, Dim> const& vec1, MathAlignedVector<float, Dim> const& vec2)
+{
+#if defined(MATH_SIMD_SSE)
+	return MathAlignedVector<float, Dim>(_mm_sub_ps(vec1.Load(), vec2.Load()));
+#else
+	MathAlignedVector<float, Dim> res(0.0f);
+	for (unsigned i = 0; i < Dim; i++)
+		res[i] = vec1[i] - vec2[i];
+	return res;
+#endif
+}
+
+// Negate operation of aligned vector
+template<unsigned Dim>
+inline auto operator-(MathAlignedVector<float, Dim> const& vec)
+{
+#if defined(MATH_SIMD_SSE)
+	return MathAlignedVector<float, Dim>(_mm_xor_ps(vec.Load(), _mm_set1_ps(-0.0f)));
+#else
+	MathAlignedVector<float, Dim> res(0.0f);
+	for (unsigned i = 0; i < Dim; i++)
+		res[i] = -vec[i];
+	return res;
+#endif
+}
+
+// Scaler multiplication operation of aligned vector
+template<unsigned Dim>
+inline auto operator*(MathAlignedVector<float, Dim> const& vec, float scale)
+{
+#if defined(MATH_SIMD_SSE)
+	return MathAlignedVector<float, Dim>(_mm_mul_ps(vec.Load(), _mm_set1_ps(scale)));
+#else
+	MathAlignedVector<float, Dim> res(0.0f);
+	for (unsigned i = 0; i < Dim; i++)
+		res[i] = vec[i] * scale;
+	return res;
+#endif
+}
+
+// Scaler multiplication operation of aligned vector
+template<unsigned Dim>
+inline auto operator*(float scale, MathAlignedVector<float, Dim> const& vec)
+{
+	return vec * scale;
+}
+
+// Scaler division operation of aligned vector
+template<unsigned Dim>
+inline auto operator/(MathAlignedVector<float, Dim> const& vec, float scale)
+{
+#if defined(MATH_SIMD_SSE)
+	return MathAlignedVector<float, Dim>(_mm_div_ps(vec.Load(), _mm_set1_ps(scale)));
+#else
+	MathAlignedVector<float, Dim> res(0.0f);
+	for (unsigned i = 0; i < Dim; i++)
+		res[i] = vec[i] / scale;
+	return res;
+#endif
+}
+
+// Dot product operation
+template<unsigned Dim>
+inline float Dot(MathAlignedVector<float, Dim> const& vec1, MathAlignedVector<float, Dim> const& vec2)
+{
+#if defined(MATH_SIMD_SSE)
+	return _mm_cvtss_f32(SimdHorizontalSum<Dim>(_mm_mul_ps(vec1.Load(), vec2.Load())));
+#else
+	float res = 0;
+	for (unsigned i = 0; i < Dim; i++)
+		res += vec1[i] * vec2[i];
+	return res;
+#endif
+}
+
+// Cross product operation
+inline AFvec3 Cross(AFvec3 const& vec1, AFvec3 const& vec2)
+{
+#if defined(MATH_SIMD_SSE)
+	__m128 a = vec1.Load(), b = vec2.Load();
+	__m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+	return AFvec3(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+#else
+	return {
+		vec1.y * vec2.z - vec1.z * vec2.y,
+		vec1.z * vec2.x - vec1.x * vec2.z,
+		vec1.x * vec2.y - vec1.y * vec2.x
+	};
+#endif
+}
+
+// Hadamard product.
+template<unsigned Dim>
+inline auto Hadamard(MathAlignedVector<float, Dim> const& vec1, MathAlignedVector<float, Dim> const& vec2)
+{
+#if defined(MATH_SIMD_SSE)
+	return MathAlignedVector<float, Dim>(_mm_mul_ps(vec1.Load(), vec2.Load()));
+#else
+	MathAlignedVector<float, Dim> res(0.0f);
+	for (unsigned i = 0; i < Dim; i++)
+		res[i] = vec1[i] * vec2[i];
+	return res;
+#endif
+}
+
+// Compute a normalized vector
+template<unsigned Dim>
+inline auto Normalize(MathAlignedVector<float, Dim> const& vec)
+{
+#if defined(MATH_SIMD_SSE)
+	__m128 reg = vec.Load();
+	__m128 sum = SimdHorizontalSum<Dim>(_mm_mul_ps(reg, reg));
+	__m128 invsqrt = _mm_div_ss(_mm_set_ss(1.0f), _mm_sqrt_ss(sum));
+	return MathAlignedVector<float, Dim>(_mm_mul_ps(reg, _mm_shuffle_ps(invsqrt, invsqrt, 0x00)));
+#else
+	return vec * (1.0f / std::sqrt(Dot(vec, vec)));
+#endif
+}
+
+// ------------------------------------ Members ------------------------------------ //
+
+inline float AFvec3::Norm() const
+{
+	return std::sqrt(Dot(*this, *this));
+}
+
+inline AFvec3& AFvec3::operator+=(AFvec3 const& vec)
+{
+	return *this = *this + vec;
+}
+
+inline AFvec3& AFvec3::operator-=(AFvec3 const& vec)
+{
+	return *this = *this - vec;
+}
+
+inline AFvec3& AFvec3::operator*=(float scale)
+{
+	return *this = *this * scale;
+}
+
+inline float AFvec4::Norm() const
+{
+	return std::sqrt(Dot(*this, *this));
+}
+
+inline AFvec4& AFvec4::operator+=(AFvec4 const& vec)
+{
+	return *this = *this + vec;
+}
+
+inline AFvec4& AFvec4::operator-=(AFvec4 const& vec)
+{
+	return *this = *this - vec;
+}
+
+inline AFvec4& AFvec4::operator*=(float scale)
+{
+	return *this = *this * scale;
+}
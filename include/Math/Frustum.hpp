@@ -0,0 +1,43 @@
+#pragma once
+
+#include "Dependencies.hpp"
+#include "Math/Matrix.hpp"
+#include "Math/VectorArray.hpp"
+
+// View frustum as 6 normalized planes (a, b, c, d) facing inwards,
+// a point p is inside a plane when a * p.x + b * p.y + c * p.z + d >= 0.
+struct Frustum
+{
+	enum Plane { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+
+	std::array<Fvec4, PLANE_COUNT> Planes;
+};
+
+// Extract the planes of projection * view (clip space z in [-w, w], as produced by
+// PerspectiveProjection and OrthogonalProjection). Passing projection * view * model gives model space planes.
+Frustum ExtractFrustum(Fmat4 const& view_proj);
+
+// Sphere test, conservative: spheres near frustum corners may pass
+bool IsSphereVisible(Frustum const& frustum, Fvec3 center, float radius);
+
+// Axis aligned box test by center and half extents, conservative like the sphere test
+bool IsBoxVisible(Frustum const& frustum, Fvec3 center, Fvec3 extent);
+
+// Test spheres in structure-of-arrays layout, SimdWidth spheres per instruction.
+// Indices of visible spheres are written to the front of visible in ascending order, returns their count.
+// visible must hold x.size() indices.
+size_t CullSpheres(Frustum const& frustum,
+	std::span<float const> x, std::span<float const> y, std::span<float const> z, std::span<float const> radius,
+	std::span<uint32_t> visible);
+
+// Test spheres of a structure-of-arrays container.
+size_t CullSpheres(Frustum const& frustum, Fvec3Array const& centers, std::span<float const> radius, std::span<uint32_t> visible);
+
+// Test axis aligned boxes given by centers and half extents in structure-of-arrays layout.
+size_t CullBoxes(Frustum const& frustum,
+	std::span<float const> x, std::span<float const> y, std::span<float const> z,
+	std::span<float const> extent_x, std::span<float const> extent_y, std::span<float const> extent_z,
+	std::span<uint32_t> visible);
+
+// Test axis aligned boxes of structure-of-arrays containers.
+size_t CullBoxes(Frustum const& frustum, Fvec3Array const& centers, Fvec3Array const& extents, std::span<uint32_t> visible);
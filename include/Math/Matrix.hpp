@@ -2,6 +2,7 @@
 
 #include "Dependencies.hpp"
 #include "Math/Vector.hpp"
+#include "Math/Simd.hpp"
 
 // Mathematical matrix
 template<class Ty, unsigned Rw, unsigned Cn>
@@ -162,24 +163,24 @@ constexpr auto operator-(MathMatrix<Ty, Rw, Cn> const& mat)
 }
 
 // Scalar mulitplication operation of matrices
-template<class Ty1, class ScTy, unsigned Rw, unsigned Cn>
+template<class Ty1, class ScTy, unsigned Rw, unsigned Cn> requires std::is_arithmetic_v<ScTy>
 constexpr auto operator*(MathMatrix<Ty1, Rw, Cn> const& mat, ScTy scale)
 {
 	MathMatrix<decltype(mat[0][0] * scale), Rw, Cn> res;
 	for (unsigned i = 0; i < Cn; i++)
-		res[i] = mat * scale;
+		res[i] = mat[i] * scale;
 	return res;
 }
 
 // Scalar mulitplication operation of matrices
-template<class Ty1, class ScTy, unsigned Rw, unsigned Cn>
+template<class Ty1, class ScTy, unsigned Rw, unsigned Cn> requires std::is_arithmetic_v<ScTy>
 constexpr auto operator*(ScTy scale, MathMatrix<Ty1, Rw, Cn> const& mat)
 {
 	return mat * scale;
 }
 
 // Scalar division operation of matrices
-template<class Ty1, class ScTy, unsigned Rw, unsigned Cn>
+template<class Ty1, class ScTy, unsigned Rw, unsigned Cn> requires std::is_arithmetic_v<ScTy>
 constexpr auto operator/(MathMatrix<Ty1, Rw, Cn> const& mat, ScTy scale)
 {
 	MathMatrix<decltype(mat[0][0] / scale), Rw, Cn> res;
@@ -211,6 +212,102 @@ constexpr auto operator*(MathMatrix<Ty1, Rw1, Dim> const& mat, MathVector<Ty2, D
 	return res;
 }
 
+// Matrix multiplication operation (4x4 float specialization)
+// Accumulates in the same order as the generic template, so results stay bit-comparable as long as the
+// compiler does not contract a * b + c into FMA (e.g. -mfma with the default -ffp-contract=fast).
+constexpr Fmat4 operator*(Fmat4 const& mat1, Fmat4 const& mat2)
+{
+	if (std::is_constant_evaluated())
+		return operator*<float, float, 4, 4, 4>(mat1, mat2);
+
+	Fmat4 res;
+
+#if defined(MATH_SIMD_AVX)
+
+	// columns are only float aligned, load them unaligned and duplicate into both lanes
+	__m128 const a0 = _mm_loadu_ps(&mat1[0].x), a1 = _mm_loadu_ps(&mat1[1].x);
+	__m128 const a2 = _mm_loadu_ps(&mat1[2].x), a3 = _mm_loadu_ps(&mat1[3].x);
+	__m256 const c0 = _mm256_set_m128(a0, a0);
+	__m256 const c1 = _mm256_set_m128(a1, a1);
+	__m256 const c2 = _mm256_set_m128(a2, a2);
+	__m256 const c3 = _mm256_set_m128(a3, a3);
+
+	// two result columns per iteration
+	for (unsigned i = 0; i < 4; i += 2)
+	{
+		__m256 const b = _mm256_loadu_ps(&mat2[i].x);
+		__m256 r = _mm256_setzero_ps();
+		r = _mm256_add_ps(r, _mm256_mul_ps(c0, _mm256_permute_ps(b, 0x00)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(c1, _mm256_permute_ps(b, 0x55)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(c2, _mm256_permute_ps(b, 0xAA)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(c3, _mm256_permute_ps(b, 0xFF)));
+		_mm256_storeu_ps(&res[i].x, r);
+	}
+
+#elif defined(MATH_SIMD_SSE)
+
+	__m128 const c0 = _mm_loadu_ps(&mat1[0].x);
+	__m128 const c1 = _mm_loadu_ps(&mat1[1].x);
+	__m128 const c2 = _mm_loadu_ps(&mat1[2].x);
+	__m128 const c3 = _mm_loadu_ps(&mat1[3].x);
+
+	for (unsigned i = 0; i < 4; i++)
+	{
+		__m128 const b = _mm_loadu_ps(&mat2[i].x);
+		__m128 r = _mm_setzero_ps();
+		r = _mm_add_ps(r, _mm_mul_ps(c0, _mm_shuffle_ps(b, b, 0x00)));
+		r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(b, b, 0x55)));
+		r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(b, b, 0xAA)));
+		r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_shuffle_ps(b, b, 0xFF)));
+		_mm_storeu_ps(&res[i].x, r);
+	}
+
+#else
+
+	for (unsigned i = 0; i < 4; i++)
+	{
+		Fvec4 const& b = mat2[i];
+		res[i].x = 0.0f + mat1[0].x * b.x + mat1[1].x * b.y + mat1[2].x * b.z + mat1[3].x * b.w;
+		res[i].y = 0.0f + mat1[0].y * b.x + mat1[1].y * b.y + mat1[2].y * b.z + mat1[3].y * b.w;
+		res[i].z = 0.0f + mat1[0].z * b.x + mat1[1].z * b.y + mat1[2].z * b.z + mat1[3].z * b.w;
+		res[i].w = 0.0f + mat1[0].w * b.x + mat1[1].w * b.y + mat1[2].w * b.z + mat1[3].w * b.w;
+	}
+
+#endif
+
+	return res;
+}
+
+// Matrix multiplication operation (4x4 float specialization, with vector outcome)
+constexpr Fvec4 operator*(Fmat4 const& mat, Fvec4 const& vec)
+{
+	if (std::is_constant_evaluated())
+		return operator*<float, float, 4, 4>(mat, vec);
+
+#if defined(MATH_SIMD_SSE)
+
+	__m128 r = _mm_setzero_ps();
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&mat[0].x), _mm_set1_ps(vec.x)));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&mat[1].x), _mm_set1_ps(vec.y)));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&mat[2].x), _mm_set1_ps(vec.z)));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&mat[3].x), _mm_set1_ps(vec.w)));
+
+	Fvec4 res;
+	_mm_storeu_ps(&res.x, r);
+	return res;
+
+#else
+
+	return {
+		0.0f + mat[0].x * vec.x + mat[1].x * vec.y + mat[2].x * vec.z + mat[3].x * vec.w,
+		0.0f + mat[0].y * vec.x + mat[1].y * vec.y + mat[2].y * vec.z + mat[3].y * vec.w,
+		0.0f + mat[0].z * vec.x + mat[1].z * vec.y + mat[2].z * vec.z + mat[3].z * vec.w,
+		0.0f + mat[0].w * vec.x + mat[1].w * vec.y + mat[2].w * vec.z + mat[3].w * vec.w
+	};
+
+#endif
+}
+
 // Matrix transpose operation
 template<class Ty, unsigned Rw, unsigned Cn>
 constexpr auto Transpose(MathMatrix<Ty, Rw, Cn> const& mat)
@@ -230,4 +327,264 @@ constexpr auto Hadamard(MathMatrix<Ty1, Rw, Cn> const& mat1, MathMatrix<Ty2, Rw,
 	for (unsigned i = 0; i < Cn; i++)
 		res[i] = Hadamard(mat1[i], mat2[i]);
 	return res;
-}
\ No newline at end of file
+}
+
+// Determinant of 2x2 matrix
+template<class Ty>
+constexpr auto Determinant(MathMatrix<Ty, 2, 2> const& mat)
+{
+	return mat[0][0] * mat[1][1] - mat[1][0] * mat[0][1];
+}
+
+// Determinant of 3x3 matrix
+template<class Ty>
+constexpr auto Determinant(MathMatrix<Ty, 3, 3> const& mat)
+{
+	return Dot(mat[0], Cross(mat[1], mat[2]));
+}
+
+// Determinant of 4x4 matrix (Laplace expansion over 2x2 sub-determinants)
+template<class Ty>
+constexpr auto Determinant(MathMatrix<Ty, 4, 4> const& mat)
+{
+	auto s0 = mat[0][0] * mat[1][1] - mat[1][0] * mat[0][1];
+	auto s1 = mat[0][0] * mat[1][2] - mat[1][0] * mat[0][2];
+	auto s2 = mat[0][0] * mat[1][3] - mat[1][0] * mat[0][3];
+	auto s3 = mat[0][1] * mat[1][2] - mat[1][1] * mat[0][2];
+	auto s4 = mat[0][1] * mat[1][3] - mat[1][1] * mat[0][3];
+	auto s5 = mat[0][2] * mat[1][3] - mat[1][2] * mat[0][3];
+	auto c5 = mat[2][2] * mat[3][3] - mat[3][2] * mat[2][3];
+	auto c4 = mat[2][1] * mat[3][3] - mat[3][1] * mat[2][3];
+	auto c3 = mat[2][1] * mat[3][2] - mat[3][1] * mat[2][2];
+	auto c2 = mat[2][0] * mat[3][3] - mat[3][0] * mat[2][3];
+	auto c1 = mat[2][0] * mat[3][2] - mat[3][0] * mat[2][2];
+	auto c0 = mat[2][0] * mat[3][1] - mat[3][0] * mat[2][1];
+	return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+// Inverse of 2x2 matrix
+template<class Ty>
+constexpr auto Inverse(MathMatrix<Ty, 2, 2> const& mat)
+{
+	using common_type = std::common_type_t<Ty, float>;
+	common_type invdet = common_type(1) / Determinant(mat);
+	return MathMatrix<common_type, 2, 2> {
+		MathVector<common_type, 2>(mat[1][1] * invdet, -mat[0][1] * invdet),
+		MathVector<common_type, 2>(-mat[1][0] * invdet, mat[0][0] * invdet)
+	};
+}
+
+// Inverse of 3x3 matrix, rows of the inverse are cross products of the columns
+template<class Ty>
+constexpr auto Inverse(MathMatrix<Ty, 3, 3> const& mat)
+{
+	using common_type = std::common_type_t<Ty, float>;
+	MathVector<common_type, 3> r0 = Cross(mat[1], mat[2]);
+	MathVector<common_type, 3> r1 = Cross(mat[2], mat[0]);
+	MathVector<common_type, 3> r2 = Cross(mat[0], mat[1]);
+	common_type invdet = common_type(1) / Dot(mat[0], r0);
+	return Transpose(MathMatrix<common_type, 3, 3>(r0 * invdet, r1 * invdet, r2 * invdet));
+}
+
+// Inverse of 4x4 matrix (cofactors over 2x2 sub-determinants)
+template<class Ty>
+constexpr auto Inverse(MathMatrix<Ty, 4, 4> const& mat)
+{
+	using common_type = std::common_type_t<Ty, float>;
+	MathMatrix<common_type, 4, 4> const a = mat;
+
+	common_type s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+	common_type s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+	common_type s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+	common_type s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+	common_type s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+	common_type s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+	common_type c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+	common_type c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+	common_type c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+	common_type c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+	common_type c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+	common_type c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+	common_type invdet = common_type(1) / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+	MathMatrix<common_type, 4, 4> res;
+	res[0][0] = ( a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * invdet;
+	res[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * invdet;
+	res[0][2] = ( a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * invdet;
+	res[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * invdet;
+	res[1][0] = (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * invdet;
+	res[1][1] = ( a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * invdet;
+	res[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * invdet;
+	res[1][3] = ( a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * invdet;
+	res[2][0] = ( a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * invdet;
+	res[2][1] = (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * invdet;
+	res[2][2] = ( a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * invdet;
+	res[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * invdet;
+	res[3][0] = (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * invdet;
+	res[3][1] = ( a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * invdet;
+	res[3][2] = (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * invdet;
+	res[3][3] = ( a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * invdet;
+	return res;
+}
+
+#if defined(MATH_SIMD_SSE)
+
+// 2x2 matrix product a * b, each matrix packed row-major in one register
+inline __m128 SimdMat2Mul(__m128 a, __m128 b)
+{
+	return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// 2x2 matrix product adj(a) * b
+inline __m128 SimdMat2AdjMul(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+// 2x2 matrix product a * adj(b)
+inline __m128 SimdMat2MulAdj(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+		_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+#endif
+
+// Inverse of 4x4 float matrix (SIMD specialization, block-wise inversion over 2x2 sub-matrices)
+inline Fmat4 Inverse(Fmat4 const& mat)
+{
+#if defined(MATH_SIMD_SSE)
+
+	// Works on columns as if they were rows, inverse and transpose commute
+	__m128 r0 = _mm_loadu_ps(&mat[0].x), r1 = _mm_loadu_ps(&mat[1].x);
+	__m128 r2 = _mm_loadu_ps(&mat[2].x), r3 = _mm_loadu_ps(&mat[3].x);
+
+	__m128 a = _mm_movelh_ps(r0, r1), b = _mm_movehl_ps(r1, r0);
+	__m128 c = _mm_movelh_ps(r2, r3), d = _mm_movehl_ps(r3, r2);
+
+	// determinants of the four 2x2 blocks
+	__m128 det_sub = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+	__m128 det_a = _mm_shuffle_ps(det_sub, det_sub, 0x00);
+	__m128 det_b = _mm_shuffle_ps(det_sub, det_sub, 0x55);
+	__m128 det_c = _mm_shuffle_ps(det_sub, det_sub, 0xAA);
+	__m128 det_d = _mm_shuffle_ps(det_sub, det_sub, 0xFF);
+
+	__m128 d_c = SimdMat2AdjMul(d, c);
+	__m128 a_b = SimdMat2AdjMul(a, b);
+
+	__m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), SimdMat2Mul(b, d_c));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), SimdMat2Mul(c, a_b));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), SimdMat2MulAdj(d, a_b));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), SimdMat2MulAdj(a, d_c));
+
+	// det = det(A)det(D) + det(B)det(C) - tr(adj(A)B adj(D)C)
+	__m128 tr = _mm_mul_ps(a_b, _mm_shuffle_ps(d_c, d_c, _MM_SHUFFLE(3, 1, 2, 0)));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(2, 3, 0, 1)));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), tr);
+
+	__m128 inv_det = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+	x = _mm_mul_ps(x, inv_det);
+	y = _mm_mul_ps(y, inv_det);
+	z = _mm_mul_ps(z, inv_det);
+	w = _mm_mul_ps(w, inv_det);
+
+	Fmat4 res;
+	_mm_storeu_ps(&res[0].x, _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(&res[1].x, _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_storeu_ps(&res[2].x, _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(&res[3].x, _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+	return res;
+
+#else
+
+	return Inverse<float>(mat);
+
+#endif
+}
+
+// Inverse of an affine 4x4 matrix (last row 0, 0, 0, 1), e.g. products of translate, rotate and scale models
+template<class Ty>
+constexpr auto AffineInverse(MathMatrix<Ty, 4, 4> const& mat)
+{
+	using common_type = std::common_type_t<Ty, float>;
+	MathVector<common_type, 3> c0 = mat[0], c1 = mat[1], c2 = mat[2], t = mat[3];
+
+	// rows of the upper 3x3 inverse
+	MathVector<common_type, 3> r0 = Cross(c1, c2);
+	MathVector<common_type, 3> r1 = Cross(c2, c0);
+	MathVector<common_type, 3> r2 = Cross(c0, c1);
+	common_type invdet = common_type(1) / Dot(c0, r0);
+	r0 *= invdet;
+	r1 *= invdet;
+	r2 *= invdet;
+
+	return MathMatrix<common_type, 4, 4> {
+		MathVector<common_type, 4>(r0.x, r1.x, r2.x, 0),
+		MathVector<common_type, 4>(r0.y, r1.y, r2.y, 0),
+		MathVector<common_type, 4>(r0.z, r1.z, r2.z, 0),
+		MathVector<common_type, 4>(-Dot(r0, t), -Dot(r1, t), -Dot(r2, t), 1)
+	};
+}
+
+// Inverse of an affine 4x4 float matrix (SIMD specialization, cofactor 3x3 transposed into place)
+inline Fmat4 AffineInverse(Fmat4 const& mat)
+{
+#if defined(MATH_SIMD_SSE)
+
+	__m128 c0 = _mm_loadu_ps(&mat[0].x), c1 = _mm_loadu_ps(&mat[1].x);
+	__m128 c2 = _mm_loadu_ps(&mat[2].x), t = _mm_loadu_ps(&mat[3].x);
+
+	// cross(a, b) = (a * b.yzx - a.yzx * b).yzx, w lanes cancel to 0
+	__m128 c0_yzx = _mm_shuffle_ps(c0, c0, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c1_yzx = _mm_shuffle_ps(c1, c1, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c2_yzx = _mm_shuffle_ps(c2, c2, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 r0 = _mm_sub_ps(_mm_mul_ps(c1, c2_yzx), _mm_mul_ps(c1_yzx, c2));
+	__m128 r1 = _mm_sub_ps(_mm_mul_ps(c2, c0_yzx), _mm_mul_ps(c2_yzx, c0));
+	__m128 r2 = _mm_sub_ps(_mm_mul_ps(c0, c1_yzx), _mm_mul_ps(c0_yzx, c1));
+	r0 = _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(3, 0, 2, 1));
+	r1 = _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(3, 0, 2, 1));
+	r2 = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(3, 0, 2, 1));
+
+	// det = dot(c0, cross(c1, c2)) broadcast
+	__m128 det = _mm_mul_ps(c0, r0);
+	det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+	det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+	r0 = _mm_mul_ps(r0, inv_det);
+	r1 = _mm_mul_ps(r1, inv_det);
+	r2 = _mm_mul_ps(r2, inv_det);
+
+	// r0..r2 are the rows of the 3x3 inverse, transpose them into columns with w = 0
+	__m128 zero = _mm_setzero_ps();
+	__m128 lo01 = _mm_unpacklo_ps(r0, r1), lo2 = _mm_unpacklo_ps(r2, zero);
+	__m128 hi01 = _mm_unpackhi_ps(r0, r1), hi2 = _mm_unpackhi_ps(r2, zero);
+	__m128 x = _mm_movelh_ps(lo01, lo2);
+	__m128 y = _mm_movehl_ps(lo2, lo01);
+	__m128 z = _mm_movelh_ps(hi01, hi2);
+
+	// translation -inv3 * t, with w = 1
+	__m128 it = _mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(x, _mm_shuffle_ps(t, t, 0x00)),
+		_mm_mul_ps(y, _mm_shuffle_ps(t, t, 0x55))),
+		_mm_mul_ps(z, _mm_shuffle_ps(t, t, 0xAA)));
+	it = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), it);
+
+	Fmat4 res;
+	_mm_storeu_ps(&res[0].x, x);
+	_mm_storeu_ps(&res[1].x, y);
+	_mm_storeu_ps(&res[2].x, z);
+	_mm_storeu_ps(&res[3].x, it);
+	return res;
+
+#else
+
+	return AffineInverse<float>(mat);
+
+#endif
+}
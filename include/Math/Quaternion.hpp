@@ -0,0 +1,210 @@
+#pragma once
+
+#include "Dependencies.hpp"
+#include "Math/Vector.hpp"
+#include "Math/Matrix.hpp"
+
+// Quaternion (x, y, z) + w, unit quaternions represent rotations
+template<class Ty>
+class MathQuaternion
+{
+public:
+
+	Ty x, y, z, w;
+
+	// Value uninitialized.
+	constexpr MathQuaternion() noexcept = default;
+
+	// Construct with vector part and scalar part.
+	constexpr MathQuaternion(auto x, auto y, auto z, auto w) noexcept
+		: x(static_cast<Ty>(x)), y(static_cast<Ty>(y)), z(static_cast<Ty>(z)), w(static_cast<Ty>(w))
+	{
+	}
+
+	// Construct with vector part and scalar part.
+	template<class Ty2>
+	constexpr MathQuaternion(MathVector<Ty2, 3> const& vec, auto w) noexcept
+		: x(static_cast<Ty>(vec.x)), y(static_cast<Ty>(vec.y)), z(static_cast<Ty>(vec.z)), w(static_cast<Ty>(w))
+	{
+	}
+
+	// Copy constructor.
+	template<class Ty2>
+	constexpr MathQuaternion(MathQuaternion<Ty2> const& quat) noexcept
+		: x(static_cast<Ty>(quat.x)), y(static_cast<Ty>(quat.y)), z(static_cast<Ty>(quat.z)), w(static_cast<Ty>(quat.w))
+	{
+	}
+
+	// Vector part.
+	constexpr MathVector<Ty, 3> Vector() const
+	{
+		return { x, y, z };
+	}
+
+	// Calculate the magnitude.
+	auto Norm() const
+	{
+		return std::sqrt(x * x + y * y + z * z + w * w);
+	}
+
+	MathQuaternion& operator*=(MathQuaternion const& quat)
+	{
+		return *this = *this * quat;
+	}
+};
+
+// -------------------- Typedefs ---------------------- //
+
+using Fquat = MathQuaternion<float>;
+
+// ------------------------------------ Functions ------------------------------------ //
+
+// Identity rotation
+template<class Ty = float>
+constexpr MathQuaternion<Ty> IdentityQuat()
+{
+	return { 0, 0, 0, 1 };
+}
+
+// Returns true if 2 quaternions are equal
+template<class Ty>
+constexpr bool operator==(MathQuaternion<Ty> const& quat1, MathQuaternion<Ty> const& quat2)
+{
+	return quat1.x == quat2.x && quat1.y == quat2.y && quat1.z == quat2.z && quat1.w == quat2.w;
+}
+
+// Addition operation between 2 quaternions
+template<class Ty>
+constexpr auto operator+(MathQuaternion<Ty> const& quat1, MathQuaternion<Ty> const& quat2)
+{
+	return MathQuaternion<Ty>(quat1.x + quat2.x, quat1.y + quat2.y, quat1.z + quat2.z, quat1.w + quat2.w);
+}
+
+// Subtraction operation between 2 quaternions
+template<class Ty>
+constexpr auto operator-(MathQuaternion<Ty> const& quat1, MathQuaternion<Ty> const& quat2)
+{
+	return MathQuaternion<Ty>(quat1.x - quat2.x, quat1.y - quat2.y, quat1.z - quat2.z, quat1.w - quat2.w);
+}
+
+// Negate operation of quaternion, represents the same rotation
+template<class Ty>
+constexpr auto operator-(MathQuaternion<Ty> const& quat)
+{
+	return MathQuaternion<Ty>(-quat.x, -quat.y, -quat.z, -quat.w);
+}
+
+// Scalar multiplication operation of quaternion
+template<class Ty>
+constexpr auto operator*(MathQuaternion<Ty> const& quat, std::type_identity_t<Ty> scale)
+{
+	return MathQuaternion<Ty>(quat.x * scale, quat.y * scale, quat.z * scale, quat.w * scale);
+}
+
+// Scalar multiplication operation of quaternion
+template<class Ty>
+constexpr auto operator*(std::type_identity_t<Ty> scale, MathQuaternion<Ty> const& quat)
+{
+	return quat * scale;
+}
+
+// Hamilton product, the rotation quat2 followed by quat1 (same order as matrix multiplication)
+template<class Ty>
+constexpr auto operator*(MathQuaternion<Ty> const& quat1, MathQuaternion<Ty> const& quat2)
+{
+	return MathQuaternion<Ty>(
+		quat1.w * quat2.x + quat1.x * quat2.w + quat1.y * quat2.z - quat1.z * quat2.y,
+		quat1.w * quat2.y - quat1.x * quat2.z + quat1.y * quat2.w + quat1.z * quat2.x,
+		quat1.w * quat2.z + quat1.x * quat2.y - quat1.y * quat2.x + quat1.z * quat2.w,
+		quat1.w * quat2.w - quat1.x * quat2.x - quat1.y * quat2.y - quat1.z * quat2.z
+	);
+}
+
+// Dot product operation
+template<class Ty>
+constexpr auto Dot(MathQuaternion<Ty> const& quat1, MathQuaternion<Ty> const& quat2)
+{
+	return quat1.x * quat2.x + quat1.y * quat2.y + quat1.z * quat2.z + quat1.w * quat2.w;
+}
+
+// Conjugate, the inverse rotation of a unit quaternion
+template<class Ty>
+constexpr auto Conjugate(MathQuaternion<Ty> const& quat)
+{
+	return MathQuaternion<Ty>(-quat.x, -quat.y, -quat.z, quat.w);
+}
+
+// Multiplicative inverse
+template<class Ty>
+constexpr auto Inverse(MathQuaternion<Ty> const& quat)
+{
+	return Conjugate(quat) * (Ty(1) / Dot(quat, quat));
+}
+
+// Compute a normalized quaternion
+template<class Ty>
+auto Normalize(MathQuaternion<Ty> const& quat)
+{
+	return quat * (Ty(1) / std::sqrt(Dot(quat, quat)));
+}
+
+// Rotation about an axis, same convention as RotateModel
+template<class Ty = float>
+auto AxisAngleQuat(Ty rad, MathVector<Ty, 3> axis = MathVector<Ty, 3>(0, 0, -1))
+{
+	axis = Normalize(axis);
+	Ty s = std::sin(rad / 2), c = std::cos(rad / 2);
+	return MathQuaternion<Ty>(axis * s, c);
+}
+
+// Rotate a vector by a unit quaternion
+template<class Ty>
+constexpr auto Rotate(MathQuaternion<Ty> const& quat, MathVector<Ty, 3> const& vec)
+{
+	// v + 2w(q x v) + 2q x (q x v)
+	MathVector<Ty, 3> q = quat.Vector();
+	MathVector<Ty, 3> t = Cross(q, vec) * Ty(2);
+	return vec + t * quat.w + Cross(q, t);
+}
+
+// Normalized linear interpolation along the shortest path
+template<class Ty>
+auto Nlerp(MathQuaternion<Ty> const& quat1, MathQuaternion<Ty> const& quat2, Ty t)
+{
+	Ty sign = Dot(quat1, quat2) < 0 ? Ty(-1) : Ty(1);
+	return Normalize(quat1 * (1 - t) + quat2 * (sign * t));
+}
+
+// Spherical linear interpolation along the shortest path
+template<class Ty>
+auto Slerp(MathQuaternion<Ty> const& quat1, MathQuaternion<Ty> const& quat2, Ty t)
+{
+	Ty cosine = Dot(quat1, quat2);
+	Ty sign = cosine < 0 ? Ty(-1) : Ty(1);
+	cosine *= sign;
+
+	// nearly parallel, sin(angle) is too small to divide by
+	if (cosine > Ty(0.9995))
+		return Normalize(quat1 * (1 - t) + quat2 * (sign * t));
+
+	Ty angle = std::acos(cosine);
+	Ty inv_sin = 1 / std::sin(angle);
+	return quat1 * (std::sin((1 - t) * angle) * inv_sin) + quat2 * (sign * std::sin(t * angle) * inv_sin);
+}
+
+// Rotation matrix of a unit quaternion, straight-line code without branches
+template<class Ty>
+constexpr auto QuatToMatrix(MathQuaternion<Ty> const& quat)
+{
+	Ty x2 = quat.x + quat.x, y2 = quat.y + quat.y, z2 = quat.z + quat.z;
+	Ty xx = quat.x * x2, yy = quat.y * y2, zz = quat.z * z2;
+	Ty xy = quat.x * y2, xz = quat.x * z2, yz = quat.y * z2;
+	Ty wx = quat.w * x2, wy = quat.w * y2, wz = quat.w * z2;
+
+	return MathMatrix<Ty, 4, 4> {
+		MathVector<Ty, 4>(1 - (yy + zz), xy + wz, xz - wy, 0),
+		MathVector<Ty, 4>(xy - wz, 1 - (xx + zz), yz + wx, 0),
+		MathVector<Ty, 4>(xz + wy, yz - wx, 1 - (xx + yy), 0),
+		MathVector<Ty, 4>(0, 0, 0, 1)
+	};
+}
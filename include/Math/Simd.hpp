@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Dependencies.hpp"
+
+// SIMD instruction set selection, resolved at compile time.
+// Define MATH_NO_SIMD to force the scalar template implementations.
+#if !defined(MATH_NO_SIMD) && defined(__AVX__)
+#define MATH_SIMD_AVX
+#endif
+
+#if !defined(MATH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MATH_SIMD_SSE
+#endif
+
+#if defined(MATH_SIMD_AVX)
+#include <immintrin.h>
+#elif defined(MATH_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+// -------------------- Packs ---------------------- //
+
+// Registers wrapped in plain structs, the intrinsic types lose their alignment and vector attributes when
+// used as template arguments
+#if defined(MATH_SIMD_SSE)
+struct SimdFloat4 { __m128 Reg; };
+#endif
+
+#if defined(MATH_SIMD_AVX)
+struct SimdFloat8 { __m256 Reg; };
+#endif
+
+// Widest float pack of the selected instruction set, batch kernels process SimdWidth lanes per instruction.
+// Plain arithmetic types act as single lane packs, so the same kernel code handles remainders.
+#if defined(MATH_SIMD_AVX)
+using SimdFloat = SimdFloat8;
+#elif defined(MATH_SIMD_SSE)
+using SimdFloat = SimdFloat4;
+#else
+using SimdFloat = float;
+#endif
+
+// Widest pack for lanes of type Ty, only float lanes are vectorized
+template<class Ty>
+using SimdPackOf = std::conditional_t<std::is_same_v<Ty, float>, SimdFloat, Ty>;
+
+template<class Pack>
+constexpr unsigned SimdLanes = std::is_arithmetic_v<Pack> ? 1 : sizeof(Pack) / sizeof(float);
+
+constexpr unsigned SimdWidth = sizeof(SimdFloat) / sizeof(float);
+
+template<class Pack> requires std::is_arithmetic_v<Pack>
+inline Pack SimdSet1(Pack value) { return value; }
+
+template<class Pack> requires std::is_arithmetic_v<Pack>
+inline Pack SimdLoad(Pack const* src) { return *src; }
+
+template<class Ty> requires std::is_arithmetic_v<Ty>
+inline void SimdStore(Ty* dst, Ty pack) { *dst = pack; }
+
+template<class Ty> requires std::is_arithmetic_v<Ty>
+inline Ty SimdAdd(Ty a, Ty b) { return a + b; }
+
+template<class Ty> requires std::is_arithmetic_v<Ty>
+inline Ty SimdSub(Ty a, Ty b) { return a - b; }
+
+template<class Ty> requires std::is_arithmetic_v<Ty>
+inline Ty SimdMul(Ty a, Ty b) { return a * b; }
+
+template<class Ty> requires std::is_arithmetic_v<Ty>
+inline Ty SimdDiv(Ty a, Ty b) { return a / b; }
+
+template<class Ty> requires std::is_arithmetic_v<Ty>
+inline Ty SimdSqrt(Ty a) { return static_cast<Ty>(std::sqrt(a)); }
+
+// Bit i set when lane i of a >= lane i of b
+template<class Ty> requires std::is_arithmetic_v<Ty>
+inline unsigned SimdGreaterEqualMask(Ty a, Ty b) { return a >= b ? 1u : 0u; }
+
+#if defined(MATH_SIMD_SSE)
+
+template<class Pack> requires std::is_same_v<Pack, SimdFloat4>
+inline SimdFloat4 SimdSet1(float value) { return { _mm_set1_ps(value) }; }
+
+template<class Pack> requires std::is_same_v<Pack, SimdFloat4>
+inline SimdFloat4 SimdLoad(float const* src) { return { _mm_loadu_ps(src) }; }
+
+inline void SimdStore(float* dst, SimdFloat4 pack) { _mm_storeu_ps(dst, pack.Reg); }
+inline SimdFloat4 SimdAdd(SimdFloat4 a, SimdFloat4 b) { return { _mm_add_ps(a.Reg, b.Reg) }; }
+inline SimdFloat4 SimdSub(SimdFloat4 a, SimdFloat4 b) { return { _mm_sub_ps(a.Reg, b.Reg) }; }
+inline SimdFloat4 SimdMul(SimdFloat4 a, SimdFloat4 b) { return { _mm_mul_ps(a.Reg, b.Reg) }; }
+inline SimdFloat4 SimdDiv(SimdFloat4 a, SimdFloat4 b) { return { _mm_div_ps(a.Reg, b.Reg) }; }
+inline SimdFloat4 SimdSqrt(SimdFloat4 a) { return { _mm_sqrt_ps(a.Reg) }; }
+inline unsigned SimdGreaterEqualMask(SimdFloat4 a, SimdFloat4 b) { return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpge_ps(a.Reg, b.Reg))); }
+
+#endif
+
+#if defined(MATH_SIMD_AVX)
+
+template<class Pack> requires std::is_same_v<Pack, SimdFloat8>
+inline SimdFloat8 SimdSet1(float value) { return { _mm256_set1_ps(value) }; }
+
+template<class Pack> requires std::is_same_v<Pack, SimdFloat8>
+inline SimdFloat8 SimdLoad(float const* src) { return { _mm256_loadu_ps(src) }; }
+
+inline void SimdStore(float* dst, SimdFloat8 pack) { _mm256_storeu_ps(dst, pack.Reg); }
+inline SimdFloat8 SimdAdd(SimdFloat8 a, SimdFloat8 b) { return { _mm256_add_ps(a.Reg, b.Reg) }; }
+inline SimdFloat8 SimdSub(SimdFloat8 a, SimdFloat8 b) { return { _mm256_sub_ps(a.Reg, b.Reg) }; }
+inline SimdFloat8 SimdMul(SimdFloat8 a, SimdFloat8 b) { return { _mm256_mul_ps(a.Reg, b.Reg) }; }
+inline SimdFloat8 SimdDiv(SimdFloat8 a, SimdFloat8 b) { return { _mm256_div_ps(a.Reg, b.Reg) }; }
+inline SimdFloat8 SimdSqrt(SimdFloat8 a) { return { _mm256_sqrt_ps(a.Reg) }; }
+inline unsigned SimdGreaterEqualMask(SimdFloat8 a, SimdFloat8 b) { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a.Reg, b.Reg, _CMP_GE_OQ))); }
+
+#endif
+
+// Run fun(Pack{}, i) over [begin, end), SimdPackOf<Ty> wide first and one lane at a time for the remainder
+template<class Ty, class Fn>
+inline void SimdForEach(size_t begin, size_t end, Fn&& fun)
+{
+	using Pack = SimdPackOf<Ty>;
+	size_t i = begin;
+	if constexpr (!std::is_same_v<Pack, Ty>)
+		for (; i + SimdLanes<Pack> <= end; i += SimdLanes<Pack>)
+			fun(Pack{}, i);
+	for (; i < end; i++)
+		fun(Ty{}, i);
+}
+
+// dst[i] = op(a[i], b[i]) for count lanes, op receives and returns packs
+template<class Ty, class Fn>
+inline void SimdBinaryLanes(Ty* dst, Ty const* a, Ty const* b, size_t count, Fn op)
+{
+	SimdForEach<Ty>(0, count, [&](auto pack, size_t i) {
+		using Pack = decltype(pack);
+		SimdStore(dst + i, op(SimdLoad<Pack>(a + i), SimdLoad<Pack>(b + i)));
+	});
+}
+
+// dst[i] = a[i] * scale for count lanes
+template<class Ty>
+inline void SimdScaleLanes(Ty* dst, Ty const* a, Ty scale, size_t count)
+{
+	SimdForEach<Ty>(0, count, [&](auto pack, size_t i) {
+		using Pack = decltype(pack);
+		SimdStore(dst + i, SimdMul(SimdLoad<Pack>(a + i), SimdSet1<Pack>(scale)));
+	});
+}
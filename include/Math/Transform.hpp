@@ -2,6 +2,8 @@
 
 #include "Dependencies.hpp"
 #include "Math/Matrix.hpp"
+#include "Math/VectorArray.hpp"
+#include "Math/Quaternion.hpp"
 
 // Translation matrix (2D)
 Fmat4 TranslateModel(Fvec2 position);
@@ -12,12 +14,25 @@ Fmat4 TranslateModel(Fvec3 position);
 // Rotation matrix (rotate about an axis)
 Fmat4 RotateModel(float rad, Fvec3 axis = Fvec3(0.0f, 0.0f, -1.0f));
 
+// Rotation matrix of a unit quaternion
+Fmat4 RotateModel(Fquat const& quat);
+
 // Scale matrix (2D)
 Fmat4 ScaleModel(Fvec2 scale);
 
 // Scale matrix
 Fmat4 ScaleModel(Fvec3 scale);
 
+// Model matrix equal to TranslateModel(translation) * RotateModel(rad, axis) * ScaleModel(scale),
+// the 12 non-constant entries are written directly instead of multiplying.
+Fmat4 ComposeModel(Fvec3 translation, float rad, Fvec3 axis, Fvec3 scale = Fvec3(1.0f));
+
+// Model matrix from a 3x3 rotation matrix, translation * rotation * scale
+Fmat4 ComposeModel(Fvec3 translation, Fmat3 const& rotation, Fvec3 scale = Fvec3(1.0f));
+
+// Model matrix from a unit quaternion, translation * rotation * scale
+Fmat4 ComposeModel(Fvec3 translation, Fquat const& rotation, Fvec3 scale = Fvec3(1.0f));
+
 // 3 dimensional view matrix, look at a certain position
 Fmat4 LookAtView(Fvec3 position, Fvec3 orientation, Fvec3 up = Fvec3(0.0f, 1.0f, 0.0f));
 
@@ -29,3 +44,34 @@ Fmat4 OrthogonalProjection(Fvec2 size);
 
 // Perspective projection matrix
 Fmat4 PerspectiveProjection(float fovy, float aspect, float near, float far);
+
+// Transform points (w = 1) by a matrix, in and out may be the same span.
+// Large batches are split across the given number of threads (0 = hardware concurrency).
+void TransformPoints(Fmat4 const& mat, std::span<Fvec3 const> in, std::span<Fvec3> out, unsigned threads = 1);
+
+// Transform directions (w = 0) by a matrix, in and out may be the same span.
+void TransformDirections(Fmat4 const& mat, std::span<Fvec3 const> in, std::span<Fvec3> out, unsigned threads = 1);
+
+// Transform points stored as separate x, y, z component arrays.
+void TransformPoints(Fmat4 const& mat,
+	std::span<float const> x, std::span<float const> y, std::span<float const> z,
+	std::span<float> out_x, std::span<float> out_y, std::span<float> out_z, unsigned threads = 1);
+
+// Transform directions stored as separate x, y, z component arrays.
+void TransformDirections(Fmat4 const& mat,
+	std::span<float const> x, std::span<float const> y, std::span<float const> z,
+	std::span<float> out_x, std::span<float> out_y, std::span<float> out_z, unsigned threads = 1);
+
+// Transform points of a structure-of-arrays container, out is resized to match.
+void TransformPoints(Fmat4 const& mat, Fvec3Array const& in, Fvec3Array& out, unsigned threads = 1);
+
+// Transform directions of a structure-of-arrays container, out is resized to match.
+void TransformDirections(Fmat4 const& mat, Fvec3Array const& in, Fvec3Array& out, unsigned threads = 1);
+
+// Compose model matrices of many objects, all spans hold the same number of elements.
+void ComposeModel(std::span<Fvec3 const> translations, std::span<Fmat3 const> rotations,
+	std::span<Fvec3 const> scales, std::span<Fmat4> out, unsigned threads = 1);
+
+// Compose model matrices of many objects from unit quaternions.
+void ComposeModel(std::span<Fvec3 const> translations, std::span<Fquat const> rotations,
+	std::span<Fvec3 const> scales, std::span<Fmat4> out, unsigned threads = 1);
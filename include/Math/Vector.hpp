@@ -20,7 +20,8 @@ public:
 	}
 
 	// Value fill initialization.
-	explicit constexpr MathVector(auto value) noexcept
+	template<class ScTy> requires std::is_arithmetic_v<ScTy>
+	explicit constexpr MathVector(ScTy value) noexcept
 	{
 		for (unsigned i = 0; i < Dim; i++)
 			m_elems[i] = static_cast<Ty>(value);
@@ -151,7 +152,8 @@ public:
 
 	constexpr MathVector() noexcept = default;
 
-	explicit constexpr MathVector(auto value) noexcept
+	template<class ScTy> requires std::is_arithmetic_v<ScTy>
+	explicit constexpr MathVector(ScTy value) noexcept
 	{
 		x = y = static_cast<Ty>(value);
 	}
@@ -218,7 +220,8 @@ public:
 
 	constexpr MathVector() noexcept = default;
 
-	explicit constexpr MathVector(auto value) noexcept
+	template<class ScTy> requires std::is_arithmetic_v<ScTy>
+	explicit constexpr MathVector(ScTy value) noexcept
 	{
 		x = y = z = static_cast<Ty>(value);
 	}
@@ -290,7 +293,8 @@ public:
 
 	constexpr MathVector() noexcept = default;
 
-	explicit constexpr MathVector(auto value) noexcept
+	template<class ScTy> requires std::is_arithmetic_v<ScTy>
+	explicit constexpr MathVector(ScTy value) noexcept
 	{
 		x = y = z = w = static_cast<Ty>(value);
 	}
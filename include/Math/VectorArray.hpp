@@ -0,0 +1,236 @@
+#pragma once
+
+#include "Dependencies.hpp"
+#include "Math/Vector.hpp"
+#include "Math/Simd.hpp"
+
+// Array of mathematical vectors in structure-of-arrays layout, one contiguous lane per component.
+// Element-wise operations on float lanes process SimdWidth elements per instruction.
+template<class Ty, unsigned Dim>
+class MathVectorArray
+{
+public:
+
+	// Empty array.
+	MathVectorArray() noexcept = default;
+
+	// Value uninitialized array of count vectors.
+	explicit MathVectorArray(size_t count)
+	{
+		Resize(count);
+	}
+
+	// Split interleaved vectors into lanes.
+	explicit MathVectorArray(std::span<MathVector<Ty, Dim> const> vecs)
+	{
+		Load(vecs);
+	}
+
+	NODISCARD size_t Size() const { return m_lanes[0].size(); }
+
+	void Resize(size_t count)
+	{
+		for (auto& lane : m_lanes)
+			lane.resize(count);
+	}
+
+	// Contiguous values of component i.
+	NODISCARD std::span<Ty> Lane(unsigned i) { return m_lanes[i]; }
+
+	// Contiguous values of component i const.
+	NODISCARD std::span<Ty const> Lane(unsigned i) const { return m_lanes[i]; }
+
+	// Gather vector at index.
+	NODISCARD MathVector<Ty, Dim> Get(size_t index) const
+	{
+		MathVector<Ty, Dim> res;
+		for (unsigned i = 0; i < Dim; i++)
+			res[i] = m_lanes[i][index];
+		return res;
+	}
+
+	// Scatter vector at index.
+	void Set(size_t index, MathVector<Ty, Dim> const& vec)
+	{
+		for (unsigned i = 0; i < Dim; i++)
+			m_lanes[i][index] = vec[i];
+	}
+
+	// Replace content with interleaved vectors.
+	void Load(std::span<MathVector<Ty, Dim> const> vecs)
+	{
+		Resize(vecs.size());
+		for (unsigned i = 0; i < Dim; i++)
+		{
+			Ty* lane = m_lanes[i].data();
+			for (size_t j = 0; j < vecs.size(); j++)
+				lane[j] = vecs[j][i];
+		}
+	}
+
+	// Write back as interleaved vectors, out must hold Size() vectors.
+	void Store(std::span<MathVector<Ty, Dim>> out) const
+	{
+		StoreInterleaved(out.data(), sizeof(MathVector<Ty, Dim>));
+	}
+
+	// Write each vector to dst + index * stride, e.g. the position attribute of a vertex staging buffer.
+	void StoreInterleaved(void* dst, size_t stride) const
+	{
+		auto* bytes = static_cast<unsigned char*>(dst);
+		for (unsigned i = 0; i < Dim; i++)
+		{
+			Ty const* lane = m_lanes[i].data();
+			for (size_t j = 0; j < Size(); j++)
+				std::memcpy(bytes + j * stride + i * sizeof(Ty), lane + j, sizeof(Ty));
+		}
+	}
+
+	MathVectorArray& operator+=(MathVectorArray const& arr)
+	{
+		for (unsigned i = 0; i < Dim; i++)
+			SimdBinaryLanes(m_lanes[i].data(), m_lanes[i].data(), arr.m_lanes[i].data(), Size(),
+				[](auto a, auto b) { return SimdAdd(a, b); });
+		return *this;
+	}
+
+	MathVectorArray& operator-=(MathVectorArray const& arr)
+	{
+		for (unsigned i = 0; i < Dim; i++)
+			SimdBinaryLanes(m_lanes[i].data(), m_lanes[i].data(), arr.m_lanes[i].data(), Size(),
+				[](auto a, auto b) { return SimdSub(a, b); });
+		return *this;
+	}
+
+	MathVectorArray& operator*=(Ty scale)
+	{
+		for (unsigned i = 0; i < Dim; i++)
+			SimdScaleLanes(m_lanes[i].data(), m_lanes[i].data(), scale, Size());
+		return *this;
+	}
+
+private:
+	// array of component lanes
+	std::array<std::vector<Ty>, Dim> m_lanes;
+};
+
+// -------------------- Typedefs ---------------------- //
+
+using Fvec2Array = MathVectorArray<float, 2>;
+using Fvec3Array = MathVectorArray<float, 3>;
+using Fvec4Array = MathVectorArray<float, 4>;
+
+// ------------------------------------ Functions ------------------------------------ //
+
+// Addition operation bewteen 2 vector arrays of the same size
+template<class Ty, unsigned Dim>
+auto operator+(MathVectorArray<Ty, Dim> const& arr1, MathVectorArray<Ty, Dim> const& arr2)
+{
+	MathVectorArray<Ty, Dim> res(arr1.Size());
+	for (unsigned i = 0; i < Dim; i++)
+		SimdBinaryLanes(res.Lane(i).data(), arr1.Lane(i).data(), arr2.Lane(i).data(), arr1.Size(),
+			[](auto a, auto b) { return SimdAdd(a, b); });
+	return res;
+}
+
+// Subtraction operation bewteen 2 vector arrays of the same size
+template<class Ty, unsigned Dim>
+auto operator-(MathVectorArray<Ty, Dim> const& arr1, MathVectorArray<Ty, Dim> const& arr2)
+{
+	MathVectorArray<Ty, Dim> res(arr1.Size());
+	for (unsigned i = 0; i < Dim; i++)
+		SimdBinaryLanes(res.Lane(i).data(), arr1.Lane(i).data(), arr2.Lane(i).data(), arr1.Size(),
+			[](auto a, auto b) { return SimdSub(a, b); });
+	return res;
+}
+
+// Scaler multiplication operation of vector array
+template<class Ty, unsigned Dim>
+auto operator*(MathVectorArray<Ty, Dim> const& arr, std::type_identity_t<Ty> scale)
+{
+	MathVectorArray<Ty, Dim> res(arr.Size());
+	for (unsigned i = 0; i < Dim; i++)
+		SimdScaleLanes(res.Lane(i).data(), arr.Lane(i).data(), scale, arr.Size());
+	return res;
+}
+
+// Scaler multiplication operation of vector array
+template<class Ty, unsigned Dim>
+auto operator*(std::type_identity_t<Ty> scale, MathVectorArray<Ty, Dim> const& arr)
+{
+	return arr * scale;
+}
+
+// Hadamard product of 2 vector arrays of the same size
+template<class Ty, unsigned Dim>
+auto Hadamard(MathVectorArray<Ty, Dim> const& arr1, MathVectorArray<Ty, Dim> const& arr2)
+{
+	MathVectorArray<Ty, Dim> res(arr1.Size());
+	for (unsigned i = 0; i < Dim; i++)
+		SimdBinaryLanes(res.Lane(i).data(), arr1.Lane(i).data(), arr2.Lane(i).data(), arr1.Size(),
+			[](auto a, auto b) { return SimdMul(a, b); });
+	return res;
+}
+
+// Element-wise dot product
+template<class Ty, unsigned Dim>
+auto Dot(MathVectorArray<Ty, Dim> const& arr1, MathVectorArray<Ty, Dim> const& arr2)
+{
+	std::vector<Ty> res(arr1.Size());
+	Ty* dst = res.data();
+	SimdForEach<Ty>(0, arr1.Size(), [&](auto pack, size_t i) {
+		using Pack = decltype(pack);
+		Pack sum = SimdMul(SimdLoad<Pack>(arr1.Lane(0).data() + i), SimdLoad<Pack>(arr2.Lane(0).data() + i));
+		for (unsigned j = 1; j < Dim; j++)
+			sum = SimdAdd(sum, SimdMul(SimdLoad<Pack>(arr1.Lane(j).data() + i), SimdLoad<Pack>(arr2.Lane(j).data() + i)));
+		SimdStore(dst + i, sum);
+	});
+	return res;
+}
+
+// Element-wise cross product
+template<class Ty>
+auto Cross(MathVectorArray<Ty, 3> const& arr1, MathVectorArray<Ty, 3> const& arr2)
+{
+	MathVectorArray<Ty, 3> res(arr1.Size());
+	Ty const* ax = arr1.Lane(0).data(), * ay = arr1.Lane(1).data(), * az = arr1.Lane(2).data();
+	Ty const* bx = arr2.Lane(0).data(), * by = arr2.Lane(1).data(), * bz = arr2.Lane(2).data();
+	Ty* rx = res.Lane(0).data(), * ry = res.Lane(1).data(), * rz = res.Lane(2).data();
+	SimdForEach<Ty>(0, arr1.Size(), [&](auto pack, size_t i) {
+		using Pack = decltype(pack);
+		Pack x1 = SimdLoad<Pack>(ax + i), y1 = SimdLoad<Pack>(ay + i), z1 = SimdLoad<Pack>(az + i);
+		Pack x2 = SimdLoad<Pack>(bx + i), y2 = SimdLoad<Pack>(by + i), z2 = SimdLoad<Pack>(bz + i);
+		SimdStore(rx + i, SimdSub(SimdMul(y1, z2), SimdMul(z1, y2)));
+		SimdStore(ry + i, SimdSub(SimdMul(z1, x2), SimdMul(x1, z2)));
+		SimdStore(rz + i, SimdSub(SimdMul(x1, y2), SimdMul(y1, x2)));
+	});
+	return res;
+}
+
+// Element-wise normalization
+template<class Ty, unsigned Dim>
+auto Normalize(MathVectorArray<Ty, Dim> const& arr)
+{
+	using common_type = std::common_type_t<Ty, float>;
+	MathVectorArray<common_type, Dim> res(arr.Size());
+
+	if constexpr (std::is_same_v<Ty, common_type>)
+	{
+		SimdForEach<Ty>(0, arr.Size(), [&](auto pack, size_t i) {
+			using Pack = decltype(pack);
+			Pack sum = SimdMul(SimdLoad<Pack>(arr.Lane(0).data() + i), SimdLoad<Pack>(arr.Lane(0).data() + i));
+			for (unsigned j = 1; j < Dim; j++)
+				sum = SimdAdd(sum, SimdMul(SimdLoad<Pack>(arr.Lane(j).data() + i), SimdLoad<Pack>(arr.Lane(j).data() + i)));
+			Pack invsqrt = SimdDiv(SimdSet1<Pack>(1.0f), SimdSqrt(sum));
+			for (unsigned j = 0; j < Dim; j++)
+				SimdStore(res.Lane(j).data() + i, SimdMul(SimdLoad<Pack>(arr.Lane(j).data() + i), invsqrt));
+		});
+	}
+	else
+	{
+		for (size_t i = 0; i < arr.Size(); i++)
+			res.Set(i, Normalize(arr.Get(i)));
+	}
+
+	return res;
+}
@@ -0,0 +1,345 @@
+#include "Graphics/Allocator.hpp"
+
+#define THISFILE "Graphics/Allocator.cpp"
+
+// Smallest range handed out by a block, keeps the free lists short for tiny uniform buffers
+static constexpr VkDeviceSize s_min_allocation_size = 256;
+
+BuddyAllocator::BuddyAllocator(VkDeviceSize size, VkDeviceSize min_size)
+{
+    ERRCHECK(std::has_single_bit(size) && min_size <= size);
+    m_max_order = static_cast<uint32_t>(std::countr_zero(size));
+    m_min_order = static_cast<uint32_t>(std::bit_width(std::bit_ceil(min_size)) - 1);
+    m_free.resize(m_max_order - m_min_order + 1);
+    m_free.back().insert(0);
+    m_free_bytes = size;
+}
+
+std::optional<VkDeviceSize> BuddyAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+    VkDeviceSize need = std::bit_ceil(std::max({ size, alignment, VkDeviceSize(1) }));
+    uint32_t order = std::max(m_min_order, static_cast<uint32_t>(std::countr_zero(need)));
+    if (order > m_max_order)
+        return std::nullopt;
+
+    // smallest free range that fits
+    uint32_t k = order;
+    while (k <= m_max_order && m_free[k - m_min_order].empty())
+        k++;
+    if (k > m_max_order)
+        return std::nullopt;
+
+    auto& list = m_free[k - m_min_order];
+    VkDeviceSize offset = *list.begin();
+    list.erase(list.begin());
+
+    // split down, the upper halves become free buddies
+    while (k > order) {
+        k--;
+        m_free[k - m_min_order].insert(offset + (VkDeviceSize(1) << k));
+    }
+
+    m_allocated.emplace(offset, order);
+    m_free_bytes -= VkDeviceSize(1) << order;
+    return offset;
+}
+
+void BuddyAllocator::Free(VkDeviceSize offset)
+{
+    auto it = m_allocated.find(offset);
+    ERRCHECK(it != m_allocated.end());
+    uint32_t order = it->second;
+    m_allocated.erase(it);
+    m_free_bytes += VkDeviceSize(1) << order;
+
+    // merge while the buddy is free as a whole
+    for (; order < m_max_order; order++)
+    {
+        auto& list = m_free[order - m_min_order];
+        auto buddy = list.find(offset ^ (VkDeviceSize(1) << order));
+        if (buddy == list.end())
+            break;
+        offset = std::min(offset, *buddy);
+        list.erase(buddy);
+    }
+
+    m_free[order - m_min_order].insert(offset);
+}
+
+VkDeviceSize BuddyAllocator::GetLargestFreeRange() const
+{
+    for (uint32_t k = m_max_order + 1; k-- > m_min_order;)
+        if (!m_free[k - m_min_order].empty())
+            return VkDeviceSize(1) << k;
+    return 0;
+}
+
+DeviceAllocator::DeviceAllocator(VkPhysicalDevice physical_device, VkDevice device, VkDeviceSize block_size)
+    : m_device(device)
+{
+    vkGetPhysicalDeviceMemoryProperties(physical_device, &m_memory_properties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    m_max_allocation_count = properties.limits.maxMemoryAllocationCount;
+
+    // small heaps (e.g. 256 MiB BAR windows) get proportionally smaller blocks
+    for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount; i++)
+    {
+        VkDeviceSize heap = m_memory_properties.memoryHeaps[m_memory_properties.memoryTypes[i].heapIndex].size;
+        m_block_sizes[i] = std::bit_floor(std::min(block_size, std::max(heap / 8, s_min_allocation_size)));
+    }
+
+    constexpr VkMemoryPropertyFlags direct_flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount && !m_direct_type; i++)
+        if ((m_memory_properties.memoryTypes[i].propertyFlags & direct_flags) == direct_flags)
+            m_direct_type = i;
+
+    if (m_direct_type)
+        m_direct_budget = m_memory_properties.memoryHeaps[m_memory_properties.memoryTypes[*m_direct_type].heapIndex].size / 2;
+}
+
+DeviceAllocator::~DeviceAllocator()
+{
+    for (auto& blocks : m_blocks)
+        for (auto& block : blocks)
+            if (block)
+                vkFreeMemory(m_device, block->Memory, nullptr);
+}
+
+uint32_t DeviceAllocator::FindMemoryType(uint32_t filter, VkMemoryPropertyFlags flags) const
+{
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+    for (uint32_t i = 0; i < m_memory_properties.memoryTypeCount && index == std::numeric_limits<uint32_t>::max(); i++)
+        if (filter & (1 << i) && (m_memory_properties.memoryTypes[i].propertyFlags & flags) == flags)
+            index = i;
+
+    ERRCHECK(index != std::numeric_limits<uint32_t>::max());
+    return index;
+}
+
+VkDeviceMemory DeviceAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t type, void** mapped)
+{
+    ERRCHECK(m_device_memory_count < m_max_allocation_count);
+
+    VkMemoryAllocateInfo alloc_i{};
+    alloc_i.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_i.allocationSize = size;
+    alloc_i.memoryTypeIndex = type;
+
+    VkDeviceMemory memory;
+    ERRCHECK(vkAllocateMemory(m_device, &alloc_i, nullptr, &memory) == VK_SUCCESS);
+
+    *mapped = nullptr;
+    if (m_memory_properties.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        bool ok = vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, mapped) == VK_SUCCESS;
+        if (!ok)
+            vkFreeMemory(m_device, memory, nullptr);
+        ERRCHECK(ok);
+    }
+
+    m_device_memory_count++;
+    m_reserved_bytes += size;
+    m_type_reserved_bytes[type] += size;
+    return memory;
+}
+
+MemoryAllocation DeviceAllocator::Allocate(VkMemoryRequirements const& req, VkMemoryPropertyFlags props)
+{
+    uint32_t type = FindMemoryType(req.memoryTypeBits, props);
+
+    std::lock_guard lock(m_mutex);
+    return AllocateFromType(req, type);
+}
+
+MemoryAllocation DeviceAllocator::AllocateFromType(VkMemoryRequirements const& req, uint32_t type, VkDeviceSize reserve_limit)
+{
+    MemoryAllocation res;
+    res.MemoryType = type;
+    res.Size = req.size;
+
+    auto& blocks = m_blocks[res.MemoryType];
+    VkDeviceSize block_size = m_block_sizes[res.MemoryType];
+
+    // counted only once the allocation exists, failures below throw
+    auto account = [&] {
+        m_allocation_count++;
+        m_requested_bytes += req.size;
+        return res;
+    };
+
+    // large requests would waste most of a block, give them their own memory
+    if (req.size > block_size / 2) {
+        if (m_type_reserved_bytes[type] + req.size > reserve_limit)
+            return {};
+        res.Memory = AllocateDeviceMemory(req.size, res.MemoryType, &res.Mapped);
+        res.Dedicated = true;
+        return account();
+    }
+
+    auto place = [&](uint32_t index) -> bool {
+        auto offset = blocks[index]->Ranges.Allocate(req.size, req.alignment);
+        if (!offset)
+            return false;
+        MemoryBlock const& block = *blocks[index];
+        res.Memory = block.Memory;
+        res.Offset = *offset;
+        res.Mapped = block.Mapped ? static_cast<char*>(block.Mapped) + *offset : nullptr;
+        res.Block = index;
+        return true;
+    };
+
+    for (uint32_t i = 0; i < blocks.size(); i++)
+        if (blocks[i] && place(i))
+            return account();
+
+    // every block is full, reuse a released slot or append
+    if (m_type_reserved_bytes[type] + block_size > reserve_limit)
+        return {};
+
+    uint32_t index = 0;
+    while (index < blocks.size() && blocks[index])
+        index++;
+    if (index == blocks.size())
+        blocks.emplace_back();
+
+    void* mapped;
+    VkDeviceMemory memory = AllocateDeviceMemory(block_size, res.MemoryType, &mapped);
+    blocks[index] = std::make_unique<MemoryBlock>(MemoryBlock{ memory, mapped, BuddyAllocator(block_size, s_min_allocation_size) });
+
+    ERRCHECK(place(index));
+    return account();
+}
+
+void DeviceAllocator::Free(MemoryAllocation const& allocation)
+{
+    if (allocation.Memory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard lock(m_mutex);
+    m_allocation_count--;
+    m_requested_bytes -= allocation.Size;
+
+    if (allocation.Dedicated) {
+        vkFreeMemory(m_device, allocation.Memory, nullptr);
+        m_device_memory_count--;
+        m_reserved_bytes -= allocation.Size;
+        m_type_reserved_bytes[allocation.MemoryType] -= allocation.Size;
+        return;
+    }
+
+    auto& blocks = m_blocks[allocation.MemoryType];
+    auto& block = blocks[allocation.Block];
+    block->Ranges.Free(allocation.Offset);
+
+    // release empty blocks, but keep the last one of a type so alloc/free cycles do not hit the driver
+    size_t live = std::count_if(blocks.begin(), blocks.end(), [](auto const& b) { return b != nullptr; });
+    if (block->Ranges.IsEmpty() && live > 1)
+    {
+        vkFreeMemory(m_device, block->Memory, nullptr);
+        m_device_memory_count--;
+        m_reserved_bytes -= block->Ranges.GetSize();
+        m_type_reserved_bytes[allocation.MemoryType] -= block->Ranges.GetSize();
+        block.reset();
+    }
+}
+
+VkBuffer DeviceAllocator::CreateBufferHandle(VkDeviceSize size, VkBufferUsageFlags usage) const
+{
+    VkBufferCreateInfo buffer_ci{};
+    buffer_ci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_ci.size = size;
+    buffer_ci.usage = usage;
+    buffer_ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer buffer;
+    ERRCHECK(vkCreateBuffer(m_device, &buffer_ci, nullptr, &buffer) == VK_SUCCESS);
+    return buffer;
+}
+
+std::pair<VkBuffer, MemoryAllocation>
+DeviceAllocator::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props)
+{
+    VkBuffer buffer = CreateBufferHandle(size, usage);
+    MemoryAllocation allocation;
+    try {
+        VkMemoryRequirements req;
+        vkGetBufferMemoryRequirements(m_device, buffer, &req);
+
+        // only buffers live in these blocks, so bufferImageGranularity never applies
+        allocation = Allocate(req, props);
+        ERRCHECK(vkBindBufferMemory(m_device, buffer, allocation.Memory, allocation.Offset) == VK_SUCCESS);
+    }
+    catch (...) {
+        // an empty allocation is not freed
+        DestroyBuffer(buffer, allocation);
+        throw;
+    }
+
+    return { buffer, allocation };
+}
+
+std::pair<VkBuffer, MemoryAllocation>
+DeviceAllocator::CreateDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage)
+{
+    VkBuffer buffer = CreateBufferHandle(size, usage);
+    MemoryAllocation allocation;
+    try {
+        VkMemoryRequirements req;
+        vkGetBufferMemoryRequirements(m_device, buffer, &req);
+
+        {
+            // the budget caps device memory of the type, blocks and buddy rounding included
+            std::lock_guard lock(m_mutex);
+            if (m_direct_type && (req.memoryTypeBits & (1 << *m_direct_type)))
+                allocation = AllocateFromType(req, *m_direct_type, m_direct_budget);
+        }
+
+        if (allocation.Memory == VK_NULL_HANDLE)
+            allocation = Allocate(req, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        ERRCHECK(vkBindBufferMemory(m_device, buffer, allocation.Memory, allocation.Offset) == VK_SUCCESS);
+    }
+    catch (...) {
+        DestroyBuffer(buffer, allocation);
+        throw;
+    }
+
+    return { buffer, allocation };
+}
+
+void DeviceAllocator::SetDirectWriteBudget(VkDeviceSize bytes)
+{
+    std::lock_guard lock(m_mutex);
+    m_direct_budget = m_direct_type ? bytes : 0;
+}
+
+void DeviceAllocator::DestroyBuffer(VkBuffer buffer, MemoryAllocation const& allocation)
+{
+    vkDestroyBuffer(m_device, buffer, nullptr);
+    Free(allocation);
+}
+
+AllocatorStats DeviceAllocator::GetStats() const
+{
+    std::lock_guard lock(m_mutex);
+
+    AllocatorStats stats;
+    stats.DeviceMemoryCount = m_device_memory_count;
+    stats.AllocationCount = m_allocation_count;
+    stats.ReservedBytes = m_reserved_bytes;
+    stats.RequestedBytes = m_requested_bytes;
+    stats.DirectWriteBytes = m_direct_type ? m_type_reserved_bytes[*m_direct_type] : 0;
+
+    for (auto const& blocks : m_blocks)
+        for (auto const& block : blocks)
+            if (block) {
+                VkDeviceSize largest = block->Ranges.GetLargestFreeRange();
+                stats.FreeBytes += block->Ranges.GetFreeBytes();
+                stats.LargestFreeRange = std::max(stats.LargestFreeRange, largest);
+                stats.BlockLargestFreeBytes += largest;
+            }
+
+    return stats;
+}
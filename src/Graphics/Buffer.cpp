@@ -1,147 +1,227 @@
 #include "Graphics/Buffer.hpp"
 #include "Graphics/Device.hpp"
+#include "Graphics/Allocator.hpp"
 
 #define THISFILE "Graphics/Buffer.cpp"
 
-static uint32_t s_FindMemoryTypeIndex(VkPhysicalDevice device, uint32_t filter, VkMemoryPropertyFlags flags)
+VertexBuffer::VertexBuffer(GraphicsDevice const& device, VkDeviceSize size)
+    : m_device(device), m_size(size)
 {
-    VkPhysicalDeviceMemoryProperties mp;
-    vkGetPhysicalDeviceMemoryProperties(device, &mp);
-
-    for (uint32_t i = 0; i < mp.memoryTypeCount; i++)
-    {
-        if (filter & (1 << i) && (mp.memoryTypes[i].propertyFlags & flags) == flags) {
-            return i;
-        }
-    }
-
-    ERRCHECK(false);
+    std::tie(m_buffer, m_memory) = m_device.GetAllocator().CreateDeviceBuffer(size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
 }
 
-static std::pair<VkBuffer, VkDeviceMemory>
-s_CreateBufferAndAllocateMemory(VkDevice device, VkPhysicalDevice pd, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props)
+VertexBuffer::~VertexBuffer()
 {
-    std::pair<VkBuffer, VkDeviceMemory> result;
-
-    VkBufferCreateInfo buffer_ci{};
-    buffer_ci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_ci.size = size;
-    buffer_ci.usage = usage;
-    buffer_ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    ERRCHECK(vkCreateBuffer(device, &buffer_ci, nullptr, &result.first) == VK_SUCCESS);
-
-    VkMemoryRequirements req;
-    vkGetBufferMemoryRequirements(device, result.first, &req);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = req.size;
-    allocInfo.memoryTypeIndex = s_FindMemoryTypeIndex(pd, req.memoryTypeBits, props);
+    m_device.GetAllocator().DestroyBuffer(m_buffer, m_memory);
+}
 
-    ERRCHECK(vkAllocateMemory(device, &allocInfo, nullptr, &result.second) == VK_SUCCESS);
+UploadTicket VertexBuffer::MapData(const void *src)
+{
+    m_shadow.Discard();
+    UploadBatch batch(m_device);
+    batch.Write(*this, src);
+    return batch.Flush();
+}
 
-    vkBindBufferMemory(device, result.first, result.second, 0);
+void VertexBuffer::Update(VkDeviceSize offset, void const* src, VkDeviceSize size)
+{
+    if (m_memory.Mapped) {
+        ERRCHECK(offset <= m_size && size <= m_size - offset);
+        std::memcpy(static_cast<char*>(m_memory.Mapped) + offset, src, size);
+        return;
+    }
+    m_shadow.Write(offset, src, size, m_size);
+}
 
-    return result;
+void VertexBuffer::Write(UploadBatch& batch, VkDeviceSize offset, void const* src, VkDeviceSize size) const
+{
+    ERRCHECK(offset <= m_size && size <= m_size - offset);
+    if (m_memory.Mapped) {
+        std::memcpy(static_cast<char*>(m_memory.Mapped) + offset, src, size);
+        return;
+    }
+    batch.Write(m_buffer, offset, src, size, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 }
 
-static void
-s_CopyViaStagingBuffer(GraphicsDevice const& device, VkDeviceSize size, void const* src, VkBuffer dst)
+void VertexBuffer::Flush(UploadBatch& batch)
 {
-    auto [stage, stage_mem] = s_CreateBufferAndAllocateMemory(device.GetDevice(), device.GetPhysicalDevice(), size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    m_shadow.Flush(batch, m_buffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+}
 
-    void* data;
-    vkMapMemory(device.GetDevice(), stage_mem, 0, size, 0, &data);
-    memcpy(data, src, size);
-    vkUnmapMemory(device.GetDevice(), stage_mem);
+UploadTicket VertexBuffer::Flush()
+{
+    UploadBatch batch(m_device);
+    Flush(batch);
+    return batch.Flush();
+}
 
-    VkCommandBuffer copy = device.CreateTmpCmd([=](VkCommandBuffer cmd) -> void
-    {
-        VkBufferCopy buffer_copy{};
-        buffer_copy.srcOffset = 0; // Optional
-        buffer_copy.dstOffset = 0; // Optional
-        buffer_copy.size = size;
-        vkCmdCopyBuffer(cmd, stage, dst, 1, &buffer_copy);
-    });
+static VkDeviceSize s_IndexSize(VkIndexType type)
+{
+    switch (type) {
+        case VK_INDEX_TYPE_UINT8_EXT: return 1;
+        case VK_INDEX_TYPE_UINT16: return 2;
+        default: return 4;
+    }
+}
 
-    VkSubmitInfo submit_i{};
-    submit_i.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_i.commandBufferCount = 1;
-    submit_i.pCommandBuffers = &copy;
+// Copy count indices into dst as type, every index must fit
+static void s_NarrowIndices(void* dst, unsigned const* src, VkDeviceSize count, VkIndexType type)
+{
+    if (type == VK_INDEX_TYPE_UINT32) {
+        std::memcpy(dst, src, count * sizeof(unsigned));
+        return;
+    }
 
-    auto queue = device.GetGraphicsQueue().Queue;
+    unsigned max = 0;
+    for (VkDeviceSize i = 0; i < count; i++)
+        max = std::max(max, src[i]);
+    ERRCHECK(max < (1u << (8 * s_IndexSize(type))));
 
-    vkQueueSubmit(queue, 1, &submit_i, VK_NULL_HANDLE);
-    vkQueueWaitIdle(queue);
+    if (type == VK_INDEX_TYPE_UINT16)
+        std::copy_n(src, count, static_cast<uint16_t*>(dst));
+    else
+        std::copy_n(src, count, static_cast<uint8_t*>(dst));
+}
 
-    device.FreeTmpCmd(copy);
+IndexBuffer::IndexBuffer(GraphicsDevice const& device, uint32_t count, uint32_t vertex_count)
+    : IndexBuffer(device, count, ChooseIndexType(device, vertex_count))
+{
+}
 
-    vkDestroyBuffer(device.GetDevice(), stage, nullptr);
-    vkFreeMemory(device.GetDevice(), stage_mem, nullptr);
+IndexBuffer::IndexBuffer(GraphicsDevice const& device, uint32_t count, VkIndexType type)
+    : m_device(device), m_size(count * s_IndexSize(type)), m_count(count), m_index_type(type)
+{
+    ERRCHECK(type != VK_INDEX_TYPE_UINT8_EXT || device.SupportsIndexTypeUint8());
+    std::tie(m_buffer, m_memory) = m_device.GetAllocator().CreateDeviceBuffer(m_size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 }
 
-VertexBuffer::VertexBuffer(GraphicsDevice const& device, VkDeviceSize size)
-    : m_device(device), m_size(size)
+IndexBuffer::~IndexBuffer()
 {
-    auto [fst, snd] = s_CreateBufferAndAllocateMemory(m_device.GetDevice(), m_device.GetPhysicalDevice(), size,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    m_device.GetAllocator().DestroyBuffer(m_buffer, m_memory);
+}
 
-    m_buffer = fst;
-    m_memory = snd;
+VkIndexType IndexBuffer::ChooseIndexType(GraphicsDevice const& device, uint32_t vertex_count)
+{
+    if (vertex_count <= 0x100 && device.SupportsIndexTypeUint8())
+        return VK_INDEX_TYPE_UINT8_EXT;
+    return vertex_count <= 0x10000 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 }
 
-VertexBuffer::~VertexBuffer()
+UploadTicket IndexBuffer::MapData(const unsigned *src)
 {
-    vkDestroyBuffer(m_device.GetDevice(), m_buffer, nullptr);
-    vkFreeMemory(m_device.GetDevice(), m_memory, nullptr);
+    m_shadow.Discard();
+    UploadBatch batch(m_device);
+    batch.Write(*this, src);
+    return batch.Flush();
 }
 
-void VertexBuffer::MapData(const void *src)
+void IndexBuffer::Update(VkDeviceSize first, unsigned const* src, VkDeviceSize count)
 {
-    s_CopyViaStagingBuffer(m_device, m_size, src, m_buffer);
+    ERRCHECK(first <= m_count && count <= m_count - first);
+    if (!count)
+        return;
+    VkDeviceSize offset = first * s_IndexSize(m_index_type), size = count * s_IndexSize(m_index_type);
+    void* dst = m_memory.Mapped ? static_cast<char*>(m_memory.Mapped) + offset : m_shadow.MarkDirty(offset, size, m_size);
+    s_NarrowIndices(dst, src, count, m_index_type);
 }
 
-IndexBuffer::IndexBuffer(GraphicsDevice const& device, VkDeviceSize size)
-    : m_device(device), m_size(size)
+void IndexBuffer::Write(UploadBatch& batch, VkDeviceSize first, unsigned const* src, VkDeviceSize count) const
 {
-    auto [fst, snd] = s_CreateBufferAndAllocateMemory(m_device.GetDevice(), m_device.GetPhysicalDevice(), size,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    ERRCHECK(first <= m_count && count <= m_count - first);
+    if (!count)
+        return;
+    VkDeviceSize offset = first * s_IndexSize(m_index_type), size = count * s_IndexSize(m_index_type);
+
+    if (m_memory.Mapped) {
+        s_NarrowIndices(static_cast<char*>(m_memory.Mapped) + offset, src, count, m_index_type);
+        return;
+    }
+    if (m_index_type == VK_INDEX_TYPE_UINT32) {
+        batch.Write(m_buffer, offset, src, size, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+        return;
+    }
 
-    m_buffer = fst;
-    m_memory = snd;
+    std::vector<char> narrowed(size);
+    s_NarrowIndices(narrowed.data(), src, count, m_index_type);
+    batch.Write(m_buffer, offset, std::move(narrowed), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 }
 
-IndexBuffer::~IndexBuffer()
+void IndexBuffer::Flush(UploadBatch& batch)
 {
-    vkDestroyBuffer(m_device.GetDevice(), m_buffer, nullptr);
-    vkFreeMemory(m_device.GetDevice(), m_memory, nullptr);
+    m_shadow.Flush(batch, m_buffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 }
 
-void IndexBuffer::MapData(const unsigned *src)
+UploadTicket IndexBuffer::Flush()
 {
-    s_CopyViaStagingBuffer(m_device, m_size, src, m_buffer);
+    UploadBatch batch(m_device);
+    Flush(batch);
+    return batch.Flush();
 }
 
 UniformBuffer::UniformBuffer(GraphicsDevice const& device, VkDeviceSize size)
 	: m_device(device), m_size(size)
 {
-    auto [b, m] = s_CreateBufferAndAllocateMemory(m_device.GetDevice(), m_device.GetPhysicalDevice(), size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	m_buffer = b;
-	m_memory = m;
+    std::tie(m_buffer, m_memory) = m_device.GetAllocator().CreateBuffer(size,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-    vkMapMemory(m_device.GetDevice(), m_memory, 0, size, 0, &m_data);
+    m_data = m_memory.Mapped;
 }
 
 UniformBuffer::~UniformBuffer()
 {
-	vkDestroyBuffer(m_device.GetDevice(), m_buffer, nullptr);
-    vkFreeMemory(m_device.GetDevice(), m_memory, nullptr);
+    m_device.GetAllocator().DestroyBuffer(m_buffer, m_memory);
 }
 
 void UniformBuffer::Update(void const* src)
 {
 	std::memcpy(m_data, src, m_size);
 }
+
+void UniformBuffer::Update(void const* src, VkDeviceSize offset, VkDeviceSize size)
+{
+	ERRCHECK(offset <= m_size && size <= m_size - offset);
+	std::memcpy(static_cast<char*>(m_data) + offset, src, size);
+}
+
+UniformRing::UniformRing(GraphicsDevice const& device, VkDeviceSize frame_size, uint32_t frame_count)
+    : m_device(device), m_frame_count(frame_count)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device.GetPhysicalDevice(), &properties);
+    m_alignment = std::max(properties.limits.minUniformBufferOffsetAlignment, VkDeviceSize(1));
+
+    // frames start aligned so every offset handed out is
+    m_frame_size = (frame_size + m_alignment - 1) / m_alignment * m_alignment;
+    ERRCHECK(m_frame_size * frame_count <= std::numeric_limits<uint32_t>::max());
+
+    std::tie(m_buffer, m_memory) = m_device.GetAllocator().CreateBuffer(m_frame_size * frame_count,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+UniformRing::~UniformRing()
+{
+    m_device.GetAllocator().DestroyBuffer(m_buffer, m_memory);
+}
+
+void UniformRing::BeginFrame(uint32_t frame)
+{
+    ERRCHECK(frame < m_frame_count);
+    m_frame_begin = m_offset = frame * m_frame_size;
+}
+
+std::pair<void*, uint32_t> UniformRing::Allocate(VkDeviceSize size)
+{
+    VkDeviceSize offset = (m_offset + m_alignment - 1) / m_alignment * m_alignment;
+    ERRCHECK(offset + size <= m_frame_begin + m_frame_size);
+    m_offset = offset + size;
+    return { static_cast<char*>(m_memory.Mapped) + offset, static_cast<uint32_t>(offset) };
+}
+
+uint32_t UniformRing::Push(void const* src, VkDeviceSize size)
+{
+    auto [dst, offset] = Allocate(size);
+    std::memcpy(dst, src, size);
+    return offset;
+}
@@ -3,20 +3,36 @@
 #include "Graphics/Window.hpp"
 #include "Graphics/Pipeline.hpp"
 #include "Graphics/Buffer.hpp"
+#include "Graphics/Allocator.hpp"
+#include "Graphics/Upload.hpp"
+#include "Graphics/Geometry.hpp"
+#include "Graphics/PipelineCache.hpp"
+#include "Graphics/PipelineRegistry.hpp"
+#include "Graphics/ShaderArchive.hpp"
 #include <vulkan/vulkan_core.h>
 
 #define THISFILE "Graphics/Device.cpp"
 
-GraphicsDevice::GraphicsDevice(GraphicsAPI const &api, DisplayWindow const& window)
+GraphicsDevice::GraphicsDevice(GraphicsAPI const &api, DisplayWindow const& window, char const* pipeline_cache_path)
 {
     InitDeviceAndQueue(api, window);
     InitSwapchain(window);
     InitCommandPool();
     InitRenderPassAndFramebuffers();
+
+    m_staging_ring = std::make_unique<StagingRing>(*this);
+    m_pipeline_cache = std::make_unique<PipelineCache>(m_physical_device, m_device, pipeline_cache_path);
+    m_shader_library = std::make_unique<ShaderLibrary>(m_device);
+    m_pipeline_registry = std::make_unique<PipelineRegistry>(*this);
 }
 
 GraphicsDevice::~GraphicsDevice()
 {
+    m_pipeline_registry.reset();
+    m_shader_library.reset();
+    m_pipeline_cache.reset();
+    m_staging_ring.reset();
+
     for (auto framebuffer : m_framebuffers)
         vkDestroyFramebuffer(m_device, framebuffer, nullptr);
     vkDestroyRenderPass(m_device, m_render_pass, nullptr);
@@ -28,6 +44,7 @@ GraphicsDevice::~GraphicsDevice()
         vkDestroyImageView(m_device, view, nullptr);
     vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
 
+    m_allocator.reset();
     vkDestroyDevice(m_device, nullptr);
 }
 
@@ -105,26 +122,44 @@ void GraphicsDevice::FreeTmpCmd(VkCommandBuffer buffer) const
     vkFreeCommandBuffers(m_device, m_tmp_pool, 1, &buffer);
 }
 
+UploadBatch GraphicsDevice::CreateUploadBatch() const
+{
+    return UploadBatch(*this);
+}
+
 void DrawCmdRecorder::BindPipeline(GraphicsPipeline const &pipeline)
 {
     vkCmdBindPipeline(Buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetPipeline());
 }
 
-void DrawCmdRecorder::BindDescriptorSets(GraphicsPipeline const& pipeline, int id)
+void DrawCmdRecorder::BindDescriptorSets(GraphicsPipeline const& pipeline, int id, std::span<uint32_t const> dynamic_offsets)
 {
-	vkCmdBindDescriptorSets(Buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetLayout(), 0, 1, &pipeline.GetDescriptorSets(id), 0, nullptr);
+	vkCmdBindDescriptorSets(Buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetLayout(), 0, pipeline.GetDescriptorSetCount(),
+		&pipeline.GetDescriptorSets(id), static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
 }
 
-void DrawCmdRecorder::BindVertexBuffer(VertexBuffer const &buffer)
+void DrawCmdRecorder::BindVertexBuffer(VertexBuffer const &buffer, uint32_t binding, VkDeviceSize offset)
 {
     VkBuffer b = buffer.GetBuffer();
-    VkDeviceSize off = 0;
-    vkCmdBindVertexBuffers(Buffer, 0, 1, &b, &off);
+    vkCmdBindVertexBuffers(Buffer, binding, 1, &b, &offset);
+}
+
+void DrawCmdRecorder::BindVertexBuffers(uint32_t first_binding, std::span<VkBuffer const> buffers, std::span<VkDeviceSize const> offsets)
+{
+    // Vulkan has no default offsets
+    std::vector<VkDeviceSize> zeros;
+    if (offsets.empty()) {
+        zeros.resize(buffers.size());
+        offsets = zeros;
+    }
+
+    ERRCHECK(offsets.size() == buffers.size());
+    vkCmdBindVertexBuffers(Buffer, first_binding, static_cast<uint32_t>(buffers.size()), buffers.data(), offsets.data());
 }
 
 void DrawCmdRecorder::BindIndexBuffer(IndexBuffer const &buffer)
 {
-    vkCmdBindIndexBuffer(Buffer, buffer.GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindIndexBuffer(Buffer, buffer.GetBuffer(), 0, buffer.GetIndexType());
 }
 
 void DrawCmdRecorder::SetViewport(VkViewport const& viewport)
@@ -171,6 +206,11 @@ void DrawCmdRecorder::DrawIndexed(uint32_t count, uint32_t instance)
     vkCmdDrawIndexed(Buffer, count, instance, 0, 0, 0);
 }
 
+void DrawCmdRecorder::DrawIndexed(Mesh const& mesh, uint32_t instance)
+{
+    vkCmdDrawIndexed(Buffer, mesh.IndexCount, instance, mesh.FirstIndex, mesh.VertexOffset, 0);
+}
+
 void DrawCmdRecorder::EndRecord()
 {
     vkCmdEndRenderPass(Buffer);
@@ -187,7 +227,7 @@ void GraphicsDevice::InitDeviceAndQueue(GraphicsAPI const &api, DisplayWindow co
     device_count = 1;
     vkEnumeratePhysicalDevices(instance, &device_count, &m_physical_device);
 
-    constexpr std::array device_extensions = {
+    std::vector<char const*> device_extensions = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
 
@@ -216,10 +256,21 @@ void GraphicsDevice::InitDeviceAndQueue(GraphicsAPI const &api, DisplayWindow co
 
     ERRCHECK(graphics_ok && present_ok);
 
+    // dedicated DMA engines expose transfer only families, copies there run beside rendering
+    m_transfer_queue.FamilyIndex = m_graphics_queue.FamilyIndex;
+    for (uint32_t i = 0; i < families.size(); i++)
+    {
+        if ((families[i].queueFlags & VK_QUEUE_TRANSFER_BIT)
+            && !(families[i].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            m_transfer_queue.FamilyIndex = i;
+            break;
+        }
+    }
+
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
     float priority = 1.0f;
 
-    for (uint32_t index : std::unordered_set{m_graphics_queue.FamilyIndex, m_present_queue.FamilyIndex})
+    for (uint32_t index : std::unordered_set{m_graphics_queue.FamilyIndex, m_present_queue.FamilyIndex, m_transfer_queue.FamilyIndex})
     {
         VkDeviceQueueCreateInfo info{};
         info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
@@ -232,8 +283,38 @@ void GraphicsDevice::InitDeviceAndQueue(GraphicsAPI const &api, DisplayWindow co
     VkPhysicalDeviceFeatures device_features{};
     device_features.samplerAnisotropy = VK_TRUE;
 
+    // core in 1.2, used by the staging ring to reclaim space without fences
+    VkPhysicalDeviceVulkan12Features vulkan12_features{};
+    vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12_features.timelineSemaphore = VK_TRUE;
+
+    // optional, lets tiny meshes use one byte indices
+    uint32_t extension_count = 0;
+    vkEnumerateDeviceExtensionProperties(m_physical_device, nullptr, &extension_count, nullptr);
+    std::vector<VkExtensionProperties> extensions(extension_count);
+    vkEnumerateDeviceExtensionProperties(m_physical_device, nullptr, &extension_count, extensions.data());
+
+    VkPhysicalDeviceIndexTypeUint8FeaturesEXT uint8_features{};
+    uint8_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_INDEX_TYPE_UINT8_FEATURES_EXT;
+
+    if (std::any_of(extensions.begin(), extensions.end(), [](auto const& e) {
+            return std::strcmp(e.extensionName, VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME) == 0; }))
+    {
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &uint8_features;
+        vkGetPhysicalDeviceFeatures2(m_physical_device, &features2);
+        m_index_type_uint8 = uint8_features.indexTypeUint8;
+    }
+
+    if (m_index_type_uint8) {
+        device_extensions.push_back(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME);
+        vulkan12_features.pNext = &uint8_features;
+    }
+
     VkDeviceCreateInfo device_ci{};
     device_ci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_ci.pNext = &vulkan12_features;
     device_ci.pQueueCreateInfos = queue_create_infos.data();
     device_ci.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
     device_ci.pEnabledFeatures = &device_features;
@@ -256,6 +337,9 @@ void GraphicsDevice::InitDeviceAndQueue(GraphicsAPI const &api, DisplayWindow co
 
     vkGetDeviceQueue(m_device, m_graphics_queue.FamilyIndex, 0, &m_graphics_queue.Queue);
     vkGetDeviceQueue(m_device, m_present_queue.FamilyIndex, 0, &m_present_queue.Queue);
+    vkGetDeviceQueue(m_device, m_transfer_queue.FamilyIndex, 0, &m_transfer_queue.Queue);
+
+    m_allocator = std::make_unique<DeviceAllocator>(m_physical_device, m_device);
 }
 
 static VkSurfaceFormatKHR s_ChooseSurfaceFormat(VkPhysicalDevice device, VkSurfaceKHR surface)
@@ -0,0 +1,90 @@
+#include "Graphics/Geometry.hpp"
+#include "Graphics/Device.hpp"
+
+#define THISFILE "Graphics/Geometry.cpp"
+
+// First free range of at least count elements, the rest of it stays free
+static std::optional<uint32_t> s_AllocateRange(std::map<uint32_t, uint32_t>& free, uint32_t count)
+{
+    auto it = std::find_if(free.begin(), free.end(), [count](auto const& range) { return range.second >= count; });
+    if (it == free.end())
+        return std::nullopt;
+
+    auto [offset, length] = *it;
+    free.erase(it);
+    if (length > count)
+        free.emplace(offset + count, length - count);
+    return offset;
+}
+
+static void s_FreeRange(std::map<uint32_t, uint32_t>& free, uint32_t offset, uint32_t count)
+{
+    auto next = free.lower_bound(offset);
+    ERRCHECK(next == free.end() || offset + count <= next->first);
+
+    // merge with the touching neighbours
+    if (next != free.end() && next->first == offset + count) {
+        count += next->second;
+        next = free.erase(next);
+    }
+    if (next != free.begin()) {
+        auto prev = std::prev(next);
+        ERRCHECK(prev->first + prev->second <= offset);
+        if (prev->first + prev->second == offset) {
+            prev->second += count;
+            return;
+        }
+    }
+    free.emplace(offset, count);
+}
+
+GeometryPool::GeometryPool(GraphicsDevice const& device, uint32_t vertex_stride, uint32_t vertex_capacity,
+                           uint32_t index_capacity, VkIndexType index_type)
+    : m_vertex_stride(vertex_stride),
+      m_vertices(device, VkDeviceSize(vertex_stride) * vertex_capacity),
+      m_indices(device, index_capacity, index_type),
+      m_free_vertex_count(vertex_capacity), m_free_index_count(index_capacity)
+{
+    m_max_mesh_vertices = index_type == VK_INDEX_TYPE_UINT8_EXT ? 0x100
+            : index_type == VK_INDEX_TYPE_UINT16 ? 0x10000 : std::numeric_limits<uint32_t>::max();
+
+    if (vertex_capacity)
+        m_free_vertices.emplace(0, vertex_capacity);
+    if (index_capacity)
+        m_free_indices.emplace(0, index_capacity);
+}
+
+Mesh GeometryPool::Add(UploadBatch& batch, void const* vertices, uint32_t vertex_count,
+                       unsigned const* indices, uint32_t index_count)
+{
+    ERRCHECK(vertex_count && index_count && vertex_count <= m_max_mesh_vertices);
+    ERRCHECK(*std::max_element(indices, indices + index_count) < vertex_count);
+
+    auto vertex_offset = s_AllocateRange(m_free_vertices, vertex_count);
+    ERRCHECK(vertex_offset);
+    auto first_index = s_AllocateRange(m_free_indices, index_count);
+    if (!first_index)
+        s_FreeRange(m_free_vertices, *vertex_offset, vertex_count);
+    ERRCHECK(first_index);
+
+    m_free_vertex_count -= vertex_count;
+    m_free_index_count -= index_count;
+
+    Mesh mesh;
+    mesh.FirstIndex = *first_index;
+    mesh.IndexCount = index_count;
+    mesh.VertexOffset = static_cast<int32_t>(*vertex_offset);
+    mesh.VertexCount = vertex_count;
+
+    m_vertices.Write(batch, VkDeviceSize(*vertex_offset) * m_vertex_stride, vertices, VkDeviceSize(vertex_count) * m_vertex_stride);
+    m_indices.Write(batch, *first_index, indices, index_count);
+    return mesh;
+}
+
+void GeometryPool::Remove(Mesh const& mesh)
+{
+    s_FreeRange(m_free_vertices, static_cast<uint32_t>(mesh.VertexOffset), mesh.VertexCount);
+    s_FreeRange(m_free_indices, mesh.FirstIndex, mesh.IndexCount);
+    m_free_vertex_count += mesh.VertexCount;
+    m_free_index_count += mesh.IndexCount;
+}
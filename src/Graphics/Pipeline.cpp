@@ -2,37 +2,18 @@
 
 #include "Dependencies.hpp"
 #include "Graphics/Device.hpp"
+#include "Graphics/PipelineCache.hpp"
+#include "Graphics/PipelineRegistry.hpp"
+#include "Graphics/ShaderArchive.hpp"
 #include <vulkan/vulkan_core.h>
 
 #define THISFILE "Graphics/Pipeline.cpp"
 
-static VkShaderModule s_CreateShaderModule(VkDevice device, char const* path)
+VkPipeline GraphicsPipeline::CreatePipeline(CreateInfo const& info, VkPipelineLayout layout)
 {
-    std::ifstream ifs(path, std::ios::ate | std::ios::binary);
-    ERRCHECK(ifs.is_open());
-    size_t fsize = ifs.tellg();
-    std::vector<char> buffer(fsize);
-    ifs.seekg(0);
-    ifs.read(buffer.data(), static_cast<std::streamsize>(fsize));
-    ifs.close();
-
-    VkShaderModuleCreateInfo shader_ci{};
-    shader_ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shader_ci.codeSize = buffer.size();
-    shader_ci.pCode = reinterpret_cast<const uint32_t*>(buffer.data());
-
-    VkShaderModule module;
-    ERRCHECK(vkCreateShaderModule(device, &shader_ci, nullptr, &module) == VK_SUCCESS);
-    return module;
-}
-
-GraphicsPipeline::GraphicsPipeline(CreateInfo const& info)
-	: m_device(*info.Device), m_pipeline{}, m_pipeline_layout{}, m_descriptor_set_layouts{}
-{
-	VkDevice device = info.Device->GetDevice();
-
-	VkShaderModule vert = s_CreateShaderModule(device, info.Vertex);
-	VkShaderModule frag = s_CreateShaderModule(device, info.Fragment);
+	// owned by the device shader library
+	VkShaderModule vert = info.Device->GetShaderLibrary().GetModule(info.Vertex);
+	VkShaderModule frag = info.Device->GetShaderLibrary().GetModule(info.Fragment);
 
 	VkPipelineShaderStageCreateInfo shader_stages_ci[] = { {}, {} };
 
@@ -46,17 +27,24 @@ GraphicsPipeline::GraphicsPipeline(CreateInfo const& info)
 	shader_stages_ci[1].module = frag;
 	shader_stages_ci[1].pName = "main";
 
-	VkVertexInputBindingDescription binding_desc{};
-	binding_desc.binding = 0;
-	binding_desc.stride = info.Input.m_stride * sizeof(float);
-	binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	VkSpecializationInfo specialization[2]{};
+	SpecializationConstants const* constants[2] = { &info.VertexConstants, &info.FragmentConstants };
+	for (int i = 0; i < 2; i++) {
+		if (constants[i]->Empty())
+			continue;
+		specialization[i].mapEntryCount = static_cast<uint32_t>(constants[i]->m_entries.size());
+		specialization[i].pMapEntries = constants[i]->m_entries.data();
+		specialization[i].dataSize = constants[i]->m_data.size();
+		specialization[i].pData = constants[i]->m_data.data();
+		shader_stages_ci[i].pSpecializationInfo = &specialization[i];
+	}
 
 	VkPipelineVertexInputStateCreateInfo vertex_input_ci{};
 	vertex_input_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	if (info.Input.m_descs.size()) {
-		vertex_input_ci.vertexBindingDescriptionCount = 1;
+		vertex_input_ci.vertexBindingDescriptionCount = info.Input.m_bindings.size();
 		vertex_input_ci.vertexAttributeDescriptionCount = info.Input.m_descs.size();
-		vertex_input_ci.pVertexBindingDescriptions = &binding_desc;
+		vertex_input_ci.pVertexBindingDescriptions = info.Input.m_bindings.data();
 		vertex_input_ci.pVertexAttributeDescriptions = info.Input.m_descs.data();
 	}
 
@@ -120,34 +108,6 @@ GraphicsPipeline::GraphicsPipeline(CreateInfo const& info)
 	dynamic_state_ci.dynamicStateCount = dynamic_states.size();
 	dynamic_state_ci.pDynamicStates = dynamic_states.data();
 
-	std::array<VkDescriptorPoolSize, 1> pool_sizes;
-	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	pool_sizes[0].descriptorCount = 0;
-
-	VkPipelineLayoutCreateInfo pipeline_layout_ci{};
-	pipeline_layout_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-	for (int i = 0;; ++i)
-	{
-		if (i >= 4 || info.Descriptors[i].m_bindings.empty())
-		{
-			pipeline_layout_ci.setLayoutCount = i;
-			pipeline_layout_ci.pSetLayouts = i ? m_descriptor_set_layouts.data() : nullptr;
-			break;
-		}
-
-		VkDescriptorSetLayoutCreateInfo layout_ci{};
-		layout_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layout_ci.bindingCount = info.Descriptors[i].m_bindings.size();
-		layout_ci.pBindings = info.Descriptors[i].m_bindings.data();
-
-		ERRCHECK(vkCreateDescriptorSetLayout(m_device.GetDevice(), &layout_ci, nullptr, &m_descriptor_set_layouts.emplace_back()) == VK_SUCCESS);
-
-		pool_sizes[0].descriptorCount += info.Descriptors[i].m_uniform_buffer_count;
-	}
-
-	ERRCHECK(vkCreatePipelineLayout(device, &pipeline_layout_ci, nullptr, &m_pipeline_layout) == VK_SUCCESS);
-
 	VkGraphicsPipelineCreateInfo pipeline_ci{};
 	pipeline_ci.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	pipeline_ci.stageCount = 2;
@@ -159,23 +119,72 @@ GraphicsPipeline::GraphicsPipeline(CreateInfo const& info)
 	pipeline_ci.pMultisampleState = &multisampling_ci;
 	pipeline_ci.pColorBlendState = &blending_ci;
 	pipeline_ci.pDynamicState = &dynamic_state_ci;
-	pipeline_ci.layout = m_pipeline_layout;
+	pipeline_ci.layout = layout;
 	pipeline_ci.renderPass = info.Device->GetRenderPass();
 	pipeline_ci.subpass = 0;
 	pipeline_ci.basePipelineHandle = VK_NULL_HANDLE;
 
-	ERRCHECK(vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_ci, nullptr, &m_pipeline) == VK_SUCCESS);
+	return info.Device->GetPipelineCache().CreateGraphicsPipeline(pipeline_ci);
+}
+
+GraphicsPipeline::GraphicsPipeline(CreateInfo const& info)
+	: GraphicsPipeline(info, nullptr)
+{
+}
+
+GraphicsPipeline::GraphicsPipeline(CreateInfo const& info, std::shared_ptr<SharedPipeline>* shared)
+	: m_device(*info.Device), m_pipeline{}, m_pipeline_layout{}, m_descriptor_set_layouts{}
+{
+	VkDevice device = info.Device->GetDevice();
+
+	std::array<VkDescriptorPoolSize, 2> pool_sizes;
+	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	pool_sizes[0].descriptorCount = 0;
+	pool_sizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	pool_sizes[1].descriptorCount = 0;
+
+	// layouts are shared through the registry and owned by it
+	PipelineRegistry& registry = info.Device->GetPipelineRegistry();
+
+	for (int i = 0; i < 4 && !info.Descriptors[i].m_bindings.empty(); ++i)
+	{
+		m_descriptor_set_layouts.push_back(registry.GetSetLayout(info.Descriptors[i].m_bindings));
+		m_descriptor_bindings.push_back(info.Descriptors[i].m_bindings);
+
+		pool_sizes[0].descriptorCount += info.Descriptors[i].m_uniform_buffer_count;
+		pool_sizes[1].descriptorCount += info.Descriptors[i].m_dynamic_uniform_buffer_count;
+	}
 
-	vkDestroyShaderModule(device, vert, nullptr);
-	vkDestroyShaderModule(device, frag, nullptr);
+	m_pipeline_layout = registry.GetPipelineLayout(m_descriptor_set_layouts);
 
-	pool_sizes[0].descriptorCount *= info.DescriptorSetsMultiplier;
+	if (!shared) {
+		m_pipeline = CreatePipeline(info, m_pipeline_layout);
+	} else {
+		// the registry found or keeps the pipeline, descriptor sets stay per object
+		if (!*shared)
+			*shared = std::make_shared<SharedPipeline>(device, CreatePipeline(info, m_pipeline_layout));
+		m_shared_pipeline = *shared;
+		m_pipeline = m_shared_pipeline->Pipeline;
+	}
+
+	m_descriptor_pool = VK_NULL_HANDLE;
+	if (m_descriptor_set_layouts.empty())
+		return;
+
+	// pool sizes must not be empty
+	uint32_t pool_size_count = 0;
+	for (auto pool_size : pool_sizes) {
+		if (pool_size.descriptorCount) {
+			pool_size.descriptorCount *= info.DescriptorSetsMultiplier;
+			pool_sizes[pool_size_count++] = pool_size;
+		}
+	}
 
 	VkDescriptorPoolCreateInfo pool_i{};
 	pool_i.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	pool_i.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+	pool_i.poolSizeCount = pool_size_count;
 	pool_i.pPoolSizes = pool_sizes.data();
-	pool_i.maxSets = info.DescriptorSetsMultiplier;
+	pool_i.maxSets = m_descriptor_set_layouts.size() * info.DescriptorSetsMultiplier;
 
 	ERRCHECK(vkCreateDescriptorPool(device, &pool_i, nullptr, &m_descriptor_pool) == VK_SUCCESS);
 
@@ -197,17 +206,17 @@ GraphicsPipeline::GraphicsPipeline(CreateInfo const& info)
 
 GraphicsPipeline::~GraphicsPipeline()
 {
-	vkDestroyPipeline(m_device.GetDevice(), m_pipeline, nullptr);
-	vkDestroyPipelineLayout(m_device.GetDevice(), m_pipeline_layout, nullptr);
-	for (int i = 0; i < m_descriptor_set_layouts.size(); ++i) {
-		vkDestroyDescriptorSetLayout(m_device.GetDevice(), m_descriptor_set_layouts[i], nullptr);
-	}
-
+	if (!m_shared_pipeline)
+		vkDestroyPipeline(m_device.GetDevice(), m_pipeline, nullptr);
 	vkDestroyDescriptorPool(m_device.GetDevice(), m_descriptor_pool, nullptr);
 }
 
-void GraphicsPipeline::WriteDescriptor(int sid, int rid, VkBuffer buffer, size_t size)
+void GraphicsPipeline::WriteDescriptor(int sid, int rid, VkBuffer buffer, size_t size, uint32_t binding)
 {
+	auto const& bindings = m_descriptor_bindings[sid];
+	auto desc = std::find_if(bindings.begin(), bindings.end(), [binding](auto const& b) { return b.binding == binding; });
+	ERRCHECK(desc != bindings.end());
+
 	VkDescriptorBufferInfo bufferInfo{};
     bufferInfo.buffer = buffer;
     bufferInfo.offset = 0;
@@ -215,13 +224,68 @@ void GraphicsPipeline::WriteDescriptor(int sid, int rid, VkBuffer buffer, size_t
 
     VkWriteDescriptorSet write{};
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    write.dstSet = m_descriptor_sets[rid];
-    write.dstBinding = 0;
+    write.dstSet = m_descriptor_sets[rid * m_descriptor_set_layouts.size() + sid];
+    write.dstBinding = binding;
     write.dstArrayElement = 0;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.descriptorType = desc->descriptorType;
     write.descriptorCount = 1;
     write.pBufferInfo = &bufferInfo;
 
     vkUpdateDescriptorSets(m_device.GetDevice(), 1, &write, 0, nullptr);
 }
 
+
+PipelineCompiler::PipelineCompiler(uint32_t thread_count)
+{
+    for (uint32_t i = 0; i < std::max(thread_count, 1u); i++)
+        m_threads.emplace_back(&PipelineCompiler::Work, this);
+}
+
+PipelineCompiler::~PipelineCompiler()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+std::future<std::unique_ptr<GraphicsPipeline>> PipelineCompiler::Submit(GraphicsPipeline::CreateInfo const& info)
+{
+    std::packaged_task<std::unique_ptr<GraphicsPipeline>()> task([info] { return std::make_unique<GraphicsPipeline>(info); });
+    auto future = task.get_future();
+    {
+        std::lock_guard lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_cv.notify_one();
+    return future;
+}
+
+std::vector<std::future<std::unique_ptr<GraphicsPipeline>>> PipelineCompiler::Submit(std::span<GraphicsPipeline::CreateInfo const> infos)
+{
+    std::vector<std::future<std::unique_ptr<GraphicsPipeline>>> futures;
+    futures.reserve(infos.size());
+    for (auto const& info : infos)
+        futures.push_back(Submit(info));
+    return futures;
+}
+
+void PipelineCompiler::Work()
+{
+    for (;;)
+    {
+        std::packaged_task<std::unique_ptr<GraphicsPipeline>()> task;
+        {
+            std::unique_lock lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+            if (m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
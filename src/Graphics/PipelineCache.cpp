@@ -0,0 +1,166 @@
+#include "Graphics/PipelineCache.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PIPELINE_CACHE_FSYNC
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define THISFILE "Graphics/PipelineCache.cpp"
+
+// Cache data of another driver or GPU is at best ignored by the driver, at worst it crashes it
+static bool s_IsCompatible(std::vector<char> const& data, VkPhysicalDeviceProperties const& properties)
+{
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    return header.headerSize >= sizeof(header) && header.headerSize <= data.size()
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+static std::vector<char> s_ReadFile(std::string const& path)
+{
+    std::ifstream ifs(path, std::ios::ate | std::ios::binary);
+    if (!ifs.is_open())
+        return {};
+    std::vector<char> data(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0);
+    ifs.read(data.data(), static_cast<std::streamsize>(data.size()));
+    return ifs ? data : std::vector<char>{};
+}
+
+// Write data to path and, where supported, flush it to the disk before returning
+static bool s_WriteFileDurable(std::string const& path, std::vector<char> const& data)
+{
+#ifdef PIPELINE_CACHE_FSYNC
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t res = write(fd, data.data() + written, data.size() - written);
+        if (res < 0 && errno == EINTR)
+            continue;
+        if (res <= 0)
+            break;
+        written += static_cast<size_t>(res);
+    }
+    bool ok = written == data.size() && fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+#else
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(data.data(), static_cast<std::streamsize>(data.size()));
+    return static_cast<bool>(ofs.flush());
+#endif
+}
+
+// Flush the directory entry of path, so a rename into it survives a system crash
+static void s_SyncParentDirectory(std::string const& path)
+{
+#ifdef PIPELINE_CACHE_FSYNC
+    std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    // best effort, some file systems do not sync directories
+    fsync(fd);
+    close(fd);
+#endif
+}
+
+PipelineCache::PipelineCache(VkPhysicalDevice physical_device, VkDevice device, std::string path)
+    : m_device(device), m_path(std::move(path))
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    m_feedback = properties.apiVersion >= VK_API_VERSION_1_3;
+
+    std::vector<char> data = s_ReadFile(m_path);
+    if (!s_IsCompatible(data, properties))
+        data.clear();
+    m_stats.LoadedBytes = data.size();
+
+    VkPipelineCacheCreateInfo cache_ci{};
+    cache_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_ci.initialDataSize = data.size();
+    cache_ci.pInitialData = data.empty() ? nullptr : data.data();
+
+    ERRCHECK(vkCreatePipelineCache(m_device, &cache_ci, nullptr, &m_cache) == VK_SUCCESS);
+}
+
+PipelineCache::~PipelineCache()
+{
+    Save();
+    vkDestroyPipelineCache(m_device, m_cache, nullptr);
+}
+
+bool PipelineCache::Save() const
+{
+    size_t size = 0;
+    if (vkGetPipelineCacheData(m_device, m_cache, &size, nullptr) != VK_SUCCESS || !size)
+        return false;
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(m_device, m_cache, &size, data.data()) != VK_SUCCESS)
+        return false;
+
+    // rename over the old file is atomic, readers see either the old or the new cache. The data is on
+    // disk before the rename, otherwise a system crash could persist the rename ahead of the contents.
+    data.resize(size);
+    std::string tmp = m_path + ".tmp";
+    std::error_code ec;
+    if (!s_WriteFileDurable(tmp, data)) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+
+    std::filesystem::rename(tmp, m_path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    s_SyncParentDirectory(m_path);
+    return true;
+}
+
+VkPipeline PipelineCache::CreateGraphicsPipeline(VkGraphicsPipelineCreateInfo const& info)
+{
+    VkPipelineCreationFeedback feedback{};
+    VkPipelineCreationFeedbackCreateInfo feedback_ci{};
+    feedback_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+    feedback_ci.pNext = info.pNext;
+    feedback_ci.pPipelineCreationFeedback = &feedback;
+
+    VkGraphicsPipelineCreateInfo pipeline_ci = info;
+    if (m_feedback)
+        pipeline_ci.pNext = &feedback_ci;
+
+    auto begin = std::chrono::steady_clock::now();
+    VkPipeline pipeline;
+    ERRCHECK(vkCreateGraphicsPipelines(m_device, m_cache, 1, &pipeline_ci, nullptr, &pipeline) == VK_SUCCESS);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    bool hit = (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)
+            && (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT);
+
+    std::lock_guard lock(m_stats_mutex);
+    m_stats.PipelineCount++;
+    m_stats.CreateMilliseconds += ms;
+    if (hit) {
+        m_stats.HitCount++;
+        m_stats.HitMilliseconds += ms;
+    }
+
+    return pipeline;
+}
+
+PipelineCacheStats PipelineCache::GetStats() const
+{
+    std::lock_guard lock(m_stats_mutex);
+    return m_stats;
+}
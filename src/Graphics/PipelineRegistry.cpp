@@ -0,0 +1,202 @@
+#include "Graphics/PipelineRegistry.hpp"
+#include "Graphics/Device.hpp"
+#include "Graphics/ShaderArchive.hpp"
+
+#define THISFILE "Graphics/PipelineRegistry.cpp"
+
+// FNV-1a
+static uint64_t s_Hash(void const* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+{
+    auto bytes = static_cast<unsigned char const*>(data);
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+template<class Ty>
+static void s_Append(std::string& key, Ty const& value)
+{
+    static_assert(std::is_trivially_copyable_v<Ty>);
+    key.append(reinterpret_cast<char const*>(&value), sizeof(Ty));
+}
+
+// Bindings sorted by binding number, without the unused immutable sampler pointer
+static std::string s_SetLayoutKey(std::span<VkDescriptorSetLayoutBinding const> bindings)
+{
+    std::vector<VkDescriptorSetLayoutBinding> sorted(bindings.begin(), bindings.end());
+    std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) { return a.binding < b.binding; });
+
+    std::string key;
+    for (auto const& binding : sorted) {
+        s_Append(key, binding.binding);
+        s_Append(key, binding.descriptorType);
+        s_Append(key, binding.descriptorCount);
+        s_Append(key, binding.stageFlags);
+    }
+    return key;
+}
+
+// Constants sorted by id with their values, bytes left over from retyped constants are skipped
+static std::string s_SpecializationKey(SpecializationConstants const& constants)
+{
+    std::vector<VkSpecializationMapEntry> sorted = constants.m_entries;
+    std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) { return a.constantID < b.constantID; });
+
+    std::string key;
+    for (auto const& entry : sorted) {
+        s_Append(key, entry.constantID);
+        s_Append(key, entry.size);
+        key.append(reinterpret_cast<char const*>(constants.m_data.data() + entry.offset), entry.size);
+    }
+    return key;
+}
+
+PipelineRegistry::PipelineRegistry(GraphicsDevice const& device)
+    : m_device(device)
+{
+}
+
+PipelineRegistry::~PipelineRegistry()
+{
+    // pipelines use the layouts
+    m_pipelines.clear();
+
+    for (auto [key, layout] : m_pipeline_layouts)
+        vkDestroyPipelineLayout(m_device.GetDevice(), layout, nullptr);
+    for (auto [key, layout] : m_set_layouts)
+        vkDestroyDescriptorSetLayout(m_device.GetDevice(), layout, nullptr);
+}
+
+VkDescriptorSetLayout PipelineRegistry::GetSetLayout(std::span<VkDescriptorSetLayoutBinding const> bindings)
+{
+    std::string key = s_SetLayoutKey(bindings);
+
+    std::lock_guard lock(m_mutex);
+    auto it = m_set_layouts.find(key);
+    if (it != m_set_layouts.end())
+        return it->second;
+
+    VkDescriptorSetLayoutCreateInfo layout_ci{};
+    layout_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layout_ci.bindingCount = static_cast<uint32_t>(bindings.size());
+    layout_ci.pBindings = bindings.data();
+
+    VkDescriptorSetLayout layout;
+    ERRCHECK(vkCreateDescriptorSetLayout(m_device.GetDevice(), &layout_ci, nullptr, &layout) == VK_SUCCESS);
+    m_set_layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+VkPipelineLayout PipelineRegistry::GetPipelineLayout(std::span<VkDescriptorSetLayout const> set_layouts)
+{
+    std::string key;
+    for (auto layout : set_layouts)
+        s_Append(key, layout);
+
+    std::lock_guard lock(m_mutex);
+    auto it = m_pipeline_layouts.find(key);
+    if (it != m_pipeline_layouts.end())
+        return it->second;
+
+    VkPipelineLayoutCreateInfo pipeline_layout_ci{};
+    pipeline_layout_ci.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_ci.setLayoutCount = static_cast<uint32_t>(set_layouts.size());
+    pipeline_layout_ci.pSetLayouts = set_layouts.empty() ? nullptr : set_layouts.data();
+
+    VkPipelineLayout layout;
+    ERRCHECK(vkCreatePipelineLayout(m_device.GetDevice(), &pipeline_layout_ci, nullptr, &layout) == VK_SUCCESS);
+    m_pipeline_layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+uint64_t PipelineRegistry::ShaderHash(char const* name)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_shader_hashes.find(name);
+        if (it != m_shader_hashes.end())
+            return it->second;
+    }
+
+    auto code = m_device.GetShaderLibrary().GetCode(name);
+    uint64_t hash = s_Hash(code.data(), code.size_bytes());
+    std::lock_guard lock(m_mutex);
+    m_shader_hashes.emplace(name, hash);
+    return hash;
+}
+
+std::string PipelineRegistry::StateKey(GraphicsPipeline::CreateInfo const& info)
+{
+    std::string key;
+    s_Append(key, ShaderHash(info.Vertex));
+    s_Append(key, ShaderHash(info.Fragment));
+
+    s_Append(key, info.Input.m_bindings.size());
+    for (auto const& binding : info.Input.m_bindings)
+        s_Append(key, binding);
+    for (auto const& desc : info.Input.m_descs)
+        s_Append(key, desc);
+
+    for (auto const& set : info.Descriptors) {
+        std::string set_key = s_SetLayoutKey(set.m_bindings);
+        s_Append(key, set_key.size());
+        key += set_key;
+    }
+
+    for (auto const* constants : { &info.VertexConstants, &info.FragmentConstants }) {
+        std::string constants_key = s_SpecializationKey(*constants);
+        s_Append(key, constants_key.size());
+        key += constants_key;
+    }
+
+    s_Append(key, info.Device->GetRenderPass());
+    return key;
+}
+
+uint64_t PipelineRegistry::Hash(GraphicsPipeline::CreateInfo const& info)
+{
+    std::string key = StateKey(info);
+    return s_Hash(key.data(), key.size());
+}
+
+std::unique_ptr<GraphicsPipeline> PipelineRegistry::GetPipeline(GraphicsPipeline::CreateInfo const& info)
+{
+    ERRCHECK(info.Device == &m_device);
+    std::string key = StateKey(info);
+
+    std::shared_ptr<GraphicsPipeline::SharedPipeline> shared;
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_pipelines.find(key);
+        if (it != m_pipelines.end())
+            shared = it->second;
+    }
+
+    // created unlocked so misses on other threads build in parallel, a racing duplicate stays with its caller
+    bool miss = !shared;
+    std::unique_ptr<GraphicsPipeline> pipeline(new GraphicsPipeline(info, &shared));
+
+    if (miss) {
+        std::lock_guard lock(m_mutex);
+        m_pipelines.try_emplace(std::move(key), std::move(shared));
+    }
+    return pipeline;
+}
+
+void PipelineRegistry::Trim()
+{
+    std::lock_guard lock(m_mutex);
+    std::erase_if(m_pipelines, [](auto const& entry) { return entry.second.use_count() == 1; });
+}
+
+size_t PipelineRegistry::GetPipelineCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_pipelines.size();
+}
+
+size_t PipelineRegistry::GetSetLayoutCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_set_layouts.size();
+}
@@ -0,0 +1,158 @@
+#include "Graphics/ShaderArchive.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SHADER_ARCHIVE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define THISFILE "Graphics/ShaderArchive.cpp"
+
+ShaderArchive::ShaderArchive(char const* path)
+{
+#ifdef SHADER_ARCHIVE_MMAP
+    int fd = open(path, O_RDONLY);
+    ERRCHECK(fd >= 0);
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && st.st_size > 0;
+    if (ok) {
+        m_size = static_cast<size_t>(st.st_size);
+        m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = m_data != MAP_FAILED;
+        if (!ok)
+            m_data = nullptr;
+    }
+    // the mapping keeps the file alive
+    close(fd);
+    ERRCHECK(ok);
+#else
+    std::ifstream ifs(path, std::ios::ate | std::ios::binary);
+    ERRCHECK(ifs.is_open());
+    m_size = static_cast<size_t>(ifs.tellg());
+    m_buffer = std::make_unique<uint32_t[]>((m_size + 3) / 4);
+    ifs.seekg(0);
+    ifs.read(reinterpret_cast<char*>(m_buffer.get()), static_cast<std::streamsize>(m_size));
+    ERRCHECK(ifs.good());
+    m_data = m_buffer.get();
+#endif
+
+    auto bytes = static_cast<char const*>(m_data);
+    ERRCHECK(m_size >= sizeof(ShaderArchiveHeader));
+    auto const& header = *reinterpret_cast<ShaderArchiveHeader const*>(bytes);
+    ERRCHECK(std::memcmp(header.Magic, SHADER_ARCHIVE_MAGIC, 4) == 0 && header.Version == SHADER_ARCHIVE_VERSION);
+    ERRCHECK(header.Count <= (m_size - sizeof(header)) / sizeof(ShaderArchiveEntry));
+
+    m_entries = { reinterpret_cast<ShaderArchiveEntry const*>(bytes + sizeof(header)), header.Count };
+    for (auto const& entry : m_entries) {
+        ERRCHECK(std::memchr(entry.Name, 0, sizeof(entry.Name)) != nullptr);
+        ERRCHECK(entry.Offset % 4 == 0 && entry.Size % 4 == 0 && entry.Size);
+        ERRCHECK(entry.Offset <= m_size && entry.Size <= m_size - entry.Offset);
+    }
+}
+
+ShaderArchive::~ShaderArchive()
+{
+#ifdef SHADER_ARCHIVE_MMAP
+    if (m_data)
+        munmap(const_cast<void*>(m_data), m_size);
+#endif
+}
+
+std::span<uint32_t const> ShaderArchive::Find(std::string_view name) const
+{
+    for (auto const& entry : m_entries)
+        if (name == entry.Name)
+            return { reinterpret_cast<uint32_t const*>(static_cast<char const*>(m_data) + entry.Offset), entry.Size / 4 };
+    return {};
+}
+
+// Caller holds the library mutex
+static std::span<uint32_t const> s_FindCode(std::vector<std::unique_ptr<ShaderArchive>> const& archives,
+                                            std::unordered_map<std::string, std::vector<uint32_t>>& files,
+                                            std::string const& name)
+{
+    for (auto const& archive : archives)
+        if (auto code = archive->Find(name); !code.empty())
+            return code;
+
+    auto it = files.find(name);
+    if (it == files.end())
+    {
+        std::ifstream ifs(name, std::ios::ate | std::ios::binary);
+        if (!ifs.is_open())
+            throw std::runtime_error("Shader " + name + " is in no mounted archive and cannot be opened as a file");
+        std::streamoff end = ifs.tellg();
+        if (end < 0)
+            throw std::runtime_error("Failed to read shader file " + name);
+        size_t size = static_cast<size_t>(end);
+        if (!size || size % 4 != 0)
+            throw std::runtime_error("Shader file " + name + " is not SPIR-V, its size is not a multiple of 4");
+        std::vector<uint32_t> code(size / 4);
+        ifs.seekg(0);
+        ifs.read(reinterpret_cast<char*>(code.data()), static_cast<std::streamsize>(size));
+        if (!ifs.good())
+            throw std::runtime_error("Failed to read shader file " + name);
+        it = files.emplace(name, std::move(code)).first;
+    }
+    return it->second;
+}
+
+ShaderLibrary::ShaderLibrary(VkDevice device)
+    : m_device(device)
+{
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+    for (auto [name, module] : m_modules)
+        vkDestroyShaderModule(m_device, module, nullptr);
+}
+
+void ShaderLibrary::Mount(char const* path)
+{
+    auto archive = std::make_unique<ShaderArchive>(path);
+    std::lock_guard lock(m_mutex);
+    m_archives.push_back(std::move(archive));
+}
+
+std::span<uint32_t const> ShaderLibrary::GetCode(std::string const& name)
+{
+    std::lock_guard lock(m_mutex);
+    return s_FindCode(m_archives, m_files, name);
+}
+
+VkShaderModule ShaderLibrary::GetModule(std::string const& name)
+{
+    std::span<uint32_t const> code;
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_modules.find(name);
+        if (it != m_modules.end())
+            return it->second;
+        code = s_FindCode(m_archives, m_files, name);
+    }
+
+    // created unlocked so other shaders are not held up by the driver, the code outlives the lock
+    VkShaderModuleCreateInfo shader_ci{};
+    shader_ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_ci.codeSize = code.size_bytes();
+    shader_ci.pCode = code.data();
+
+    VkShaderModule module;
+    ERRCHECK(vkCreateShaderModule(m_device, &shader_ci, nullptr, &module) == VK_SUCCESS);
+
+    std::lock_guard lock(m_mutex);
+    auto [it, inserted] = m_modules.try_emplace(name, module);
+    // another thread created the module meanwhile
+    if (!inserted)
+        vkDestroyShaderModule(m_device, module, nullptr);
+    return it->second;
+}
+
+size_t ShaderLibrary::GetModuleCount() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_modules.size();
+}
@@ -0,0 +1,470 @@
+#include "Graphics/Upload.hpp"
+#include "Graphics/Device.hpp"
+#include "Graphics/Buffer.hpp"
+
+#define THISFILE "Graphics/Upload.cpp"
+
+// Staged ranges start on this boundary, keeps copies on the fast path of most DMA engines
+static constexpr VkDeviceSize s_staging_alignment = 16;
+
+static VkSemaphore s_CreateTimeline(VkDevice device)
+{
+    VkSemaphoreTypeCreateInfo type_ci{};
+    type_ci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_ci.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_ci.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_ci{};
+    semaphore_ci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_ci.pNext = &type_ci;
+
+    VkSemaphore semaphore;
+    ERRCHECK(vkCreateSemaphore(device, &semaphore_ci, nullptr, &semaphore) == VK_SUCCESS);
+    return semaphore;
+}
+
+static VkCommandPool s_CreateTransientPool(VkDevice device, uint32_t family)
+{
+    VkCommandPoolCreateInfo pool_ci{};
+    pool_ci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_ci.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_ci.queueFamilyIndex = family;
+
+    VkCommandPool pool;
+    ERRCHECK(vkCreateCommandPool(device, &pool_ci, nullptr, &pool) == VK_SUCCESS);
+    return pool;
+}
+
+static uint64_t s_CounterValue(VkDevice device, VkSemaphore timeline)
+{
+    uint64_t value;
+    ERRCHECK(vkGetSemaphoreCounterValue(device, timeline, &value) == VK_SUCCESS);
+    return value;
+}
+
+static void s_WaitValue(VkDevice device, VkSemaphore timeline, uint64_t value)
+{
+    VkSemaphoreWaitInfo wait_i{};
+    wait_i.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_i.semaphoreCount = 1;
+    wait_i.pSemaphores = &timeline;
+    wait_i.pValues = &value;
+
+    ERRCHECK(vkWaitSemaphores(device, &wait_i, UINT64_MAX) == VK_SUCCESS);
+}
+
+static VkBufferMemoryBarrier s_BufferBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+    VkAccessFlags src_access, VkAccessFlags dst_access, uint32_t src_family, uint32_t dst_family)
+{
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = src_access;
+    barrier.dstAccessMask = dst_access;
+    barrier.srcQueueFamilyIndex = src_family;
+    barrier.dstQueueFamilyIndex = dst_family;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    return barrier;
+}
+
+// Submit cmd, optionally waiting for a timeline value, and signal every semaphore of signals to value
+static void s_SubmitTimeline(VkQueue queue, VkCommandBuffer cmd, VkSemaphore wait, uint64_t wait_value,
+    VkPipelineStageFlags wait_stage, std::span<VkSemaphore const> signals, uint64_t value)
+{
+    std::array<uint64_t, 2> signal_values = { value, value };
+    ERRCHECK(signals.size() <= signal_values.size());
+
+    VkTimelineSemaphoreSubmitInfo timeline_i{};
+    timeline_i.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_i.waitSemaphoreValueCount = wait ? 1 : 0;
+    timeline_i.pWaitSemaphoreValues = &wait_value;
+    timeline_i.signalSemaphoreValueCount = static_cast<uint32_t>(signals.size());
+    timeline_i.pSignalSemaphoreValues = signal_values.data();
+
+    VkSubmitInfo submit_i{};
+    submit_i.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_i.pNext = &timeline_i;
+    submit_i.waitSemaphoreCount = wait ? 1 : 0;
+    submit_i.pWaitSemaphores = &wait;
+    submit_i.pWaitDstStageMask = &wait_stage;
+    submit_i.commandBufferCount = 1;
+    submit_i.pCommandBuffers = &cmd;
+    submit_i.signalSemaphoreCount = static_cast<uint32_t>(signals.size());
+    submit_i.pSignalSemaphores = signals.data();
+
+    ERRCHECK(vkQueueSubmit(queue, 1, &submit_i, VK_NULL_HANDLE) == VK_SUCCESS);
+}
+
+static void s_BeginOneTime(VkCommandBuffer cmd)
+{
+    VkCommandBufferBeginInfo begin_i{};
+    begin_i.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_i.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    ERRCHECK(vkBeginCommandBuffer(cmd, &begin_i) == VK_SUCCESS);
+}
+
+bool UploadTicket::IsComplete() const
+{
+    return !m_ring || m_ring->IsComplete(m_value);
+}
+
+void UploadTicket::Wait() const
+{
+    if (m_ring)
+        m_ring->Wait(m_value);
+}
+
+StagingRing::StagingRing(GraphicsDevice const& device, VkDeviceSize size)
+    : m_device(device), m_size(size)
+{
+    VkDevice dev = device.GetDevice();
+
+    std::tie(m_buffer, m_memory) = device.GetAllocator().CreateBuffer(size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    uint32_t transfer_family = device.GetTransferQueue().FamilyIndex;
+    uint32_t graphics_family = device.GetGraphicsQueue().FamilyIndex;
+
+    m_pool = s_CreateTransientPool(dev, transfer_family);
+    if (transfer_family != graphics_family)
+        m_acquire_pool = s_CreateTransientPool(dev, graphics_family);
+
+    m_copy_timeline = s_CreateTimeline(dev);
+    m_ready_timeline = s_CreateTimeline(dev);
+}
+
+StagingRing::~StagingRing()
+{
+    VkDevice dev = m_device.GetDevice();
+    s_WaitValue(dev, m_copy_timeline, m_submitted);
+    s_WaitValue(dev, m_ready_timeline, m_submitted);
+    Reclaim();
+
+    vkDestroySemaphore(dev, m_copy_timeline, nullptr);
+    vkDestroySemaphore(dev, m_ready_timeline, nullptr);
+    vkDestroyCommandPool(dev, m_pool, nullptr);
+    if (m_acquire_pool)
+        vkDestroyCommandPool(dev, m_acquire_pool, nullptr);
+    m_device.GetAllocator().DestroyBuffer(m_buffer, m_memory);
+}
+
+UploadTicket StagingRing::Upload(std::span<UploadWrite const> writes)
+{
+    if (writes.empty())
+        return {};
+
+    Reclaim();
+
+    // destination order groups the copy regions per buffer and lets adjacent writes merge
+    std::vector<UploadWrite> sorted(writes.begin(), writes.end());
+    std::stable_sort(sorted.begin(), sorted.end(), [](UploadWrite const& a, UploadWrite const& b) {
+        return a.Dst != b.Dst ? std::less<VkBuffer>()(a.Dst, b.Dst) : a.DstOffset < b.DstOffset;
+    });
+
+    std::vector<VkDeviceSize> packed(sorted.size());
+    VkDeviceSize total = 0;
+    VkPipelineStageFlags dst_stages = 0;
+    for (size_t i = 0; i < sorted.size(); i++) {
+        bool same_dst = i && sorted[i].Dst == sorted[i - 1].Dst;
+
+        // checked before anything is allocated or reserved, writes to the same buffer must not overlap
+        ERRCHECK(!same_dst || sorted[i - 1].DstOffset + sorted[i - 1].Size <= sorted[i].DstOffset);
+
+        // writes continuing the previous destination range stay unpadded so their regions merge
+        bool continues = same_dst && sorted[i - 1].DstOffset + sorted[i - 1].Size == sorted[i].DstOffset;
+        packed[i] = continues ? total : (total + s_staging_alignment - 1) & ~(s_staging_alignment - 1);
+        total = packed[i] + sorted[i].Size;
+        dst_stages |= sorted[i].DstStage;
+    }
+
+    InFlight entry{};
+    VkBuffer stage;
+    VkDeviceSize stage_offset;
+    char* data;
+
+    if (total > m_size) {
+        std::tie(entry.Buffer, entry.Memory) = m_device.GetAllocator().CreateBuffer(total,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        stage = entry.Buffer;
+        stage_offset = 0;
+        data = static_cast<char*>(entry.Memory.Mapped);
+    }
+    else {
+        stage = m_buffer;
+        stage_offset = Reserve(total);
+        data = static_cast<char*>(m_memory.Mapped) + stage_offset;
+    }
+
+    entry.End = m_head;
+
+    // one region and one barrier per run of writes contiguous in both staging and destination
+    std::vector<VkBufferCopy> regions;
+    std::vector<VkBufferMemoryBarrier> barriers;
+    std::vector<std::pair<VkBuffer, size_t>> groups;
+
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        UploadWrite const& write = sorted[i];
+        std::memcpy(data + packed[i], write.Src, write.Size);
+
+        VkBufferCopy region{ stage_offset + packed[i], write.DstOffset, write.Size };
+
+        if (groups.empty() || groups.back().first != write.Dst)
+            groups.emplace_back(write.Dst, 0);
+        else {
+            VkBufferCopy& last = regions.back();
+            if (last.srcOffset + last.size == region.srcOffset && last.dstOffset + last.size == region.dstOffset) {
+                last.size += region.size;
+                barriers.back().size += region.size;
+                barriers.back().dstAccessMask |= write.DstAccess;
+                continue;
+            }
+        }
+
+        regions.push_back(region);
+        barriers.push_back(s_BufferBarrier(write.Dst, write.DstOffset, write.Size, VK_ACCESS_TRANSFER_WRITE_BIT,
+                write.DstAccess, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED));
+        groups.back().second++;
+    }
+
+    CommandQueue transfer = m_device.GetTransferQueue();
+    CommandQueue graphics = m_device.GetGraphicsQueue();
+
+    entry.Cmd = NextCmd(m_pool, m_free_cmds);
+    s_BeginOneTime(entry.Cmd);
+
+    // on the graphics queue earlier draws may still read the destinations, an execution dependency covers the write after read
+    if (!IsAsync())
+        vkCmdPipelineBarrier(entry.Cmd, dst_stages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+    VkBufferCopy const* group_regions = regions.data();
+    for (auto [dst, count] : groups) {
+        vkCmdCopyBuffer(entry.Cmd, stage, dst, static_cast<uint32_t>(count), group_regions);
+        group_regions += count;
+    }
+
+    entry.Value = ++m_submitted;
+    uint32_t barrier_count = static_cast<uint32_t>(barriers.size());
+
+    if (!IsAsync())
+    {
+        vkCmdPipelineBarrier(entry.Cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stages, 0, 0, nullptr,
+                barrier_count, barriers.data(), 0, nullptr);
+        ERRCHECK(vkEndCommandBuffer(entry.Cmd) == VK_SUCCESS);
+
+        VkSemaphore signals[] = { m_copy_timeline, m_ready_timeline };
+        s_SubmitTimeline(graphics.Queue, entry.Cmd, VK_NULL_HANDLE, 0, 0, signals, entry.Value);
+    }
+    else
+    {
+        std::vector<VkBufferMemoryBarrier> releases = barriers;
+        for (size_t i = 0; i < barriers.size(); i++)
+        {
+            // the destination access mask is ignored on release, the source one on acquire
+            releases[i].dstAccessMask = 0;
+            barriers[i].srcAccessMask = 0;
+            releases[i].srcQueueFamilyIndex = barriers[i].srcQueueFamilyIndex = transfer.FamilyIndex;
+            releases[i].dstQueueFamilyIndex = barriers[i].dstQueueFamilyIndex = graphics.FamilyIndex;
+        }
+
+        vkCmdPipelineBarrier(entry.Cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0, 0, nullptr, barrier_count, releases.data(), 0, nullptr);
+        ERRCHECK(vkEndCommandBuffer(entry.Cmd) == VK_SUCCESS);
+
+        s_SubmitTimeline(transfer.Queue, entry.Cmd, VK_NULL_HANDLE, 0, 0, { &m_copy_timeline, 1 }, entry.Value);
+
+        // matching acquire on the graphics queue, chained to the copy through the semaphore wait stage
+        Acquire acquire{ entry.Value, NextCmd(m_acquire_pool, m_free_acquire_cmds) };
+        s_BeginOneTime(acquire.Cmd);
+        vkCmdPipelineBarrier(acquire.Cmd, dst_stages, dst_stages, 0, 0, nullptr, barrier_count, barriers.data(), 0, nullptr);
+        ERRCHECK(vkEndCommandBuffer(acquire.Cmd) == VK_SUCCESS);
+
+        s_SubmitTimeline(graphics.Queue, acquire.Cmd, m_copy_timeline, entry.Value, dst_stages,
+                { &m_ready_timeline, 1 }, entry.Value);
+        m_acquires.push_back(acquire);
+    }
+
+    m_in_flight.push_back(entry);
+    return { this, entry.Value };
+}
+
+void StagingRing::Wait(uint64_t value) const
+{
+    s_WaitValue(m_device.GetDevice(), m_ready_timeline, value);
+}
+
+bool StagingRing::IsComplete(uint64_t value) const
+{
+    return s_CounterValue(m_device.GetDevice(), m_ready_timeline) >= value;
+}
+
+VkDeviceSize StagingRing::Reserve(VkDeviceSize size)
+{
+    if (m_in_flight.empty())
+        m_head = m_tail = 0;
+
+    VkDeviceSize offset = (m_head + s_staging_alignment - 1) & ~(s_staging_alignment - 1);
+
+    // a range never wraps around the end, skip to the start instead
+    if (offset % m_size + size > m_size)
+        offset = (offset / m_size + 1) * m_size;
+
+    while (offset + size - m_tail > m_size)
+    {
+        if (m_in_flight.empty()) {
+            m_head = m_tail = offset = 0;
+            break;
+        }
+
+        s_WaitValue(m_device.GetDevice(), m_copy_timeline, m_in_flight.front().Value);
+        Reclaim();
+    }
+
+    m_head = offset + size;
+    return offset % m_size;
+}
+
+void StagingRing::Reclaim()
+{
+    VkDevice dev = m_device.GetDevice();
+
+    // staging space is free as soon as the copy finished, the graphics side acquire may still be pending
+    uint64_t copied = s_CounterValue(dev, m_copy_timeline);
+    while (!m_in_flight.empty() && m_in_flight.front().Value <= copied)
+    {
+        InFlight const& entry = m_in_flight.front();
+        m_tail = entry.End;
+        m_free_cmds.push_back(entry.Cmd);
+        if (entry.Buffer)
+            m_device.GetAllocator().DestroyBuffer(entry.Buffer, entry.Memory);
+        m_in_flight.pop_front();
+    }
+
+    uint64_t ready = s_CounterValue(dev, m_ready_timeline);
+    while (!m_acquires.empty() && m_acquires.front().Value <= ready)
+    {
+        m_free_acquire_cmds.push_back(m_acquires.front().Cmd);
+        m_acquires.pop_front();
+    }
+}
+
+VkCommandBuffer StagingRing::NextCmd(VkCommandPool pool, std::vector<VkCommandBuffer>& free_cmds)
+{
+    if (!free_cmds.empty()) {
+        VkCommandBuffer cmd = free_cmds.back();
+        free_cmds.pop_back();
+        return cmd;
+    }
+
+    VkCommandBufferAllocateInfo cmd_i{};
+    cmd_i.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmd_i.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmd_i.commandPool = pool;
+    cmd_i.commandBufferCount = 1;
+
+    VkCommandBuffer cmd;
+    ERRCHECK(vkAllocateCommandBuffers(m_device.GetDevice(), &cmd_i, &cmd) == VK_SUCCESS);
+    return cmd;
+}
+
+UploadBatch::UploadBatch(GraphicsDevice const& device)
+    : m_device(device)
+{
+}
+
+void UploadBatch::Write(VkBuffer dst, VkDeviceSize dst_offset, void const* src, VkDeviceSize size,
+                        VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    if (!size)
+        return;
+
+    m_writes.push_back({ dst, dst_offset, src, size, dst_stage, dst_access });
+    m_bytes += size;
+}
+
+void UploadBatch::Write(VkBuffer dst, VkDeviceSize dst_offset, std::vector<char>&& bytes,
+                        VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    if (bytes.empty())
+        return;
+
+    m_owned.push_back(std::move(bytes));
+    Write(dst, dst_offset, m_owned.back().data(), m_owned.back().size(), dst_stage, dst_access);
+}
+
+void UploadBatch::Write(VertexBuffer const& dst, void const* src)
+{
+    if (void* mapped = dst.GetMappedData()) {
+        std::memcpy(mapped, src, dst.GetSize());
+        return;
+    }
+    Write(dst.GetBuffer(), 0, src, dst.GetSize(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+}
+
+void UploadBatch::Write(IndexBuffer& dst, unsigned const* src)
+{
+    if (dst.GetIndexType() != VK_INDEX_TYPE_UINT32 || dst.GetMappedData()) {
+        dst.Update(0, src, dst.GetCount());
+        dst.Flush(*this);
+        return;
+    }
+    Write(dst.GetBuffer(), 0, src, dst.GetSize(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+}
+
+UploadTicket UploadBatch::Flush()
+{
+    UploadTicket ticket = m_device.GetStagingRing().Upload(m_writes);
+    m_writes.clear();
+    m_owned.clear();
+    m_bytes = 0;
+    return ticket;
+}
+
+void BufferShadow::Write(VkDeviceSize offset, void const* src, VkDeviceSize size, VkDeviceSize buffer_size)
+{
+    if (void* dst = MarkDirty(offset, size, buffer_size))
+        std::memcpy(dst, src, size);
+}
+
+void* BufferShadow::MarkDirty(VkDeviceSize offset, VkDeviceSize size, VkDeviceSize buffer_size)
+{
+    ERRCHECK(offset <= buffer_size && size <= buffer_size - offset);
+    if (!size)
+        return nullptr;
+
+    VkDeviceSize begin = offset, end = offset + size;
+    auto range_end = [](auto const& range) { return range.first + range.second.size(); };
+
+    // ranges touching or overlapping [begin, end) are [first, last)
+    auto first = m_dirty.upper_bound(begin);
+    if (first != m_dirty.begin() && range_end(*std::prev(first)) >= begin)
+        --first;
+    auto last = first;
+    for (; last != m_dirty.end() && last->first <= end; ++last)
+        end = std::max(end, range_end(*last));
+
+    if (first == last)
+        return m_dirty.emplace(begin, std::vector<char>(size)).first->second.data();
+
+    // a range starting at the merged begin grows in place, the others are copied into it
+    begin = std::min(begin, first->first);
+    std::vector<char> bytes;
+    auto copy = first;
+    if (first->first == begin)
+        bytes = std::move((copy++)->second);
+    bytes.resize(end - begin);
+    for (; copy != last; ++copy)
+        std::memcpy(bytes.data() + (copy->first - begin), copy->second.data(), copy->second.size());
+
+    m_dirty.erase(first, last);
+    return m_dirty.emplace(begin, std::move(bytes)).first->second.data() + (offset - begin);
+}
+
+void BufferShadow::Flush(UploadBatch& batch, VkBuffer dst, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access)
+{
+    for (auto& [begin, bytes] : m_dirty)
+        batch.Write(dst, begin, std::move(bytes), dst_stage, dst_access);
+    m_dirty.clear();
+}
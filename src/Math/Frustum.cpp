@@ -0,0 +1,130 @@
+#include "Math/Frustum.hpp"
+#include "Math/Simd.hpp"
+
+#define THISFILE "Math/Frustum.cpp"
+
+Frustum ExtractFrustum(Fmat4 const& view_proj)
+{
+	auto row = [&](unsigned i) { return Fvec4(view_proj[0][i], view_proj[1][i], view_proj[2][i], view_proj[3][i]); };
+	Fvec4 const r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+	// Gribb-Hartmann: -w <= x, y, z <= w in clip space
+	Frustum res;
+	res.Planes[Frustum::PLANE_LEFT] = r3 + r0;
+	res.Planes[Frustum::PLANE_RIGHT] = r3 - r0;
+	res.Planes[Frustum::PLANE_BOTTOM] = r3 + r1;
+	res.Planes[Frustum::PLANE_TOP] = r3 - r1;
+	res.Planes[Frustum::PLANE_NEAR] = r3 + r2;
+	res.Planes[Frustum::PLANE_FAR] = r3 - r2;
+
+	// unit normals make d + n . p a signed distance, comparable with radii and extents
+	for (auto& plane : res.Planes)
+		plane = plane / Fvec3(plane).Norm();
+	return res;
+}
+
+// Signed distance of a point, same operation order as the batched kernel
+static float s_PlaneDistance(Fvec4 const& plane, Fvec3 const& point)
+{
+	return plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
+}
+
+bool IsSphereVisible(Frustum const& frustum, Fvec3 center, float radius)
+{
+	for (auto const& plane : frustum.Planes)
+		if (!(s_PlaneDistance(plane, center) + radius >= 0.0f))
+			return false;
+	return true;
+}
+
+bool IsBoxVisible(Frustum const& frustum, Fvec3 center, Fvec3 extent)
+{
+	for (auto const& plane : frustum.Planes)
+	{
+		// projected radius of the box onto the plane normal
+		float radius = std::abs(plane.x) * extent.x + std::abs(plane.y) * extent.y + std::abs(plane.z) * extent.z;
+		if (!(s_PlaneDistance(plane, center) + radius >= 0.0f))
+			return false;
+	}
+	return true;
+}
+
+// Test count bounds against all planes and append indices of the visible ones.
+// Spheres read in[0..3] as x, y, z, radius; boxes read in[0..5] as x, y, z, extent x, y, z.
+template<bool Box>
+static size_t s_Cull(Frustum const& frustum, float const* const* in, size_t count, uint32_t* visible)
+{
+	float planes[Frustum::PLANE_COUNT][4], abs_normals[Frustum::PLANE_COUNT][3];
+	for (unsigned p = 0; p < Frustum::PLANE_COUNT; p++)
+		for (unsigned i = 0; i < 4; i++) {
+			planes[p][i] = frustum.Planes[p][i];
+			if (i < 3)
+				abs_normals[p][i] = std::abs(frustum.Planes[p][i]);
+		}
+
+	size_t visible_count = 0;
+	SimdForEach<float>(0, count, [&](auto pack, size_t i) {
+		using Pack = decltype(pack);
+		Pack const x = SimdLoad<Pack>(in[0] + i), y = SimdLoad<Pack>(in[1] + i), z = SimdLoad<Pack>(in[2] + i);
+		Pack const zero = SimdSet1<Pack>(0.0f);
+		unsigned mask = (1u << SimdLanes<Pack>) - 1;
+
+		for (unsigned p = 0; p < Frustum::PLANE_COUNT && mask; p++)
+		{
+			Pack dist = SimdAdd(SimdAdd(SimdAdd(
+				SimdMul(SimdSet1<Pack>(planes[p][0]), x),
+				SimdMul(SimdSet1<Pack>(planes[p][1]), y)),
+				SimdMul(SimdSet1<Pack>(planes[p][2]), z)),
+				SimdSet1<Pack>(planes[p][3]));
+
+			Pack radius;
+			if constexpr (Box)
+				radius = SimdAdd(SimdAdd(
+					SimdMul(SimdSet1<Pack>(abs_normals[p][0]), SimdLoad<Pack>(in[3] + i)),
+					SimdMul(SimdSet1<Pack>(abs_normals[p][1]), SimdLoad<Pack>(in[4] + i))),
+					SimdMul(SimdSet1<Pack>(abs_normals[p][2]), SimdLoad<Pack>(in[5] + i)));
+			else
+				radius = SimdLoad<Pack>(in[3] + i);
+
+			mask &= SimdGreaterEqualMask(SimdAdd(dist, radius), zero);
+		}
+
+		// compact the surviving lanes
+		for (; mask; mask &= mask - 1)
+			visible[visible_count++] = static_cast<uint32_t>(i + std::countr_zero(mask));
+	});
+	return visible_count;
+}
+
+size_t CullSpheres(Frustum const& frustum,
+	std::span<float const> x, std::span<float const> y, std::span<float const> z, std::span<float const> radius,
+	std::span<uint32_t> visible)
+{
+	size_t count = x.size();
+	ERRCHECK(y.size() == count && z.size() == count && radius.size() == count && visible.size() >= count);
+	float const* in[] = { x.data(), y.data(), z.data(), radius.data() };
+	return s_Cull<false>(frustum, in, count, visible.data());
+}
+
+size_t CullSpheres(Frustum const& frustum, Fvec3Array const& centers, std::span<float const> radius, std::span<uint32_t> visible)
+{
+	return CullSpheres(frustum, centers.Lane(0), centers.Lane(1), centers.Lane(2), radius, visible);
+}
+
+size_t CullBoxes(Frustum const& frustum,
+	std::span<float const> x, std::span<float const> y, std::span<float const> z,
+	std::span<float const> extent_x, std::span<float const> extent_y, std::span<float const> extent_z,
+	std::span<uint32_t> visible)
+{
+	size_t count = x.size();
+	ERRCHECK(y.size() == count && z.size() == count && extent_x.size() == count
+		&& extent_y.size() == count && extent_z.size() == count && visible.size() >= count);
+	float const* in[] = { x.data(), y.data(), z.data(), extent_x.data(), extent_y.data(), extent_z.data() };
+	return s_Cull<true>(frustum, in, count, visible.data());
+}
+
+size_t CullBoxes(Frustum const& frustum, Fvec3Array const& centers, Fvec3Array const& extents, std::span<uint32_t> visible)
+{
+	return CullBoxes(frustum, centers.Lane(0), centers.Lane(1), centers.Lane(2),
+		extents.Lane(0), extents.Lane(1), extents.Lane(2), visible);
+}
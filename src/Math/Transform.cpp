@@ -17,10 +17,11 @@ Fmat4 TranslateModel(Fvec3 position)
 	};
 }
 
-Fmat4 RotateModel(float rad, Fvec3 axis)
+// Upper 3x3 part of RotateModel
+static Fmat3 s_AxisAngleRotation(float rad, Fvec3 axis)
 {
 	if (rad == 0)
-		return Fmat4(1);
+		return Fmat3(1);
 	axis = Normalize(axis);
 	float c = std::cos(rad), s = std::sin(rad);
 	auto fun1 = [&](int i) -> float { return c + axis[i] * axis[i] * (1 - c); };
@@ -28,13 +29,22 @@ Fmat4 RotateModel(float rad, Fvec3 axis)
 	auto fun3 = [&](int i, int j, int k) -> float { return (1 - c) * axis[i] * axis[j] - s * axis[k]; };
 
 	return {
-		Fvec4(fun1(0), fun2(0, 1, 2), fun3(0, 2, 1), 0.0f),
-		Fvec4(fun3(0, 1, 2), fun1(1), fun2(1, 2, 0), 0.0f),
-		Fvec4(fun2(0, 2, 1), fun3(1, 2, 0), fun1(2), 0.0f),
-		Fvec4(0, 0, 0, 1)
+		Fvec3(fun1(0), fun2(0, 1, 2), fun3(0, 2, 1)),
+		Fvec3(fun3(0, 1, 2), fun1(1), fun2(1, 2, 0)),
+		Fvec3(fun2(0, 2, 1), fun3(1, 2, 0), fun1(2))
 	};
 }
 
+Fmat4 RotateModel(float rad, Fvec3 axis)
+{
+	return ComposeModel(Fvec3(0.0f), s_AxisAngleRotation(rad, axis));
+}
+
+Fmat4 RotateModel(Fquat const& quat)
+{
+	return QuatToMatrix(quat);
+}
+
 Fmat4 ScaleModel(Fvec2 scale)
 {
 	return ScaleModel(Fvec3(scale[0], scale[1], 1.0f));
@@ -50,6 +60,49 @@ Fmat4 ScaleModel(Fvec3 scale)
 	};
 }
 
+// Columns of rotation scaled per axis, translation in the last column
+static void s_ComposeModel(Fmat4& res, Fvec3 const& translation, Fvec3 const& c0, Fvec3 const& c1, Fvec3 const& c2, Fvec3 const& scale)
+{
+	res[0] = Fvec4(c0.x * scale.x, c0.y * scale.x, c0.z * scale.x, 0.0f);
+	res[1] = Fvec4(c1.x * scale.y, c1.y * scale.y, c1.z * scale.y, 0.0f);
+	res[2] = Fvec4(c2.x * scale.z, c2.y * scale.z, c2.z * scale.z, 0.0f);
+	res[3] = Fvec4(translation.x, translation.y, translation.z, 1.0f);
+}
+
+// Same entries as QuatToMatrix, columns only
+static void s_ComposeModel(Fmat4& res, Fvec3 const& translation, Fquat const& quat, Fvec3 const& scale)
+{
+	float x2 = quat.x + quat.x, y2 = quat.y + quat.y, z2 = quat.z + quat.z;
+	float xx = quat.x * x2, yy = quat.y * y2, zz = quat.z * z2;
+	float xy = quat.x * y2, xz = quat.x * z2, yz = quat.y * z2;
+	float wx = quat.w * x2, wy = quat.w * y2, wz = quat.w * z2;
+
+	s_ComposeModel(res, translation,
+		Fvec3(1 - (yy + zz), xy + wz, xz - wy),
+		Fvec3(xy - wz, 1 - (xx + zz), yz + wx),
+		Fvec3(xz + wy, yz - wx, 1 - (xx + yy)),
+		scale);
+}
+
+Fmat4 ComposeModel(Fvec3 translation, float rad, Fvec3 axis, Fvec3 scale)
+{
+	return ComposeModel(translation, s_AxisAngleRotation(rad, axis), scale);
+}
+
+Fmat4 ComposeModel(Fvec3 translation, Fmat3 const& rotation, Fvec3 scale)
+{
+	Fmat4 res;
+	s_ComposeModel(res, translation, rotation[0], rotation[1], rotation[2], scale);
+	return res;
+}
+
+Fmat4 ComposeModel(Fvec3 translation, Fquat const& rotation, Fvec3 scale)
+{
+	Fmat4 res;
+	s_ComposeModel(res, translation, rotation, scale);
+	return res;
+}
+
 Fmat4 LookAtView(Fvec3 position, Fvec3 orientation, Fvec3 up)
 {
 	Fmat4 res(1.0f);
@@ -101,4 +154,222 @@ Fmat4 PerspectiveProjection(float fovy, float aspect, float near, float far)
 	res[2][3] = -1.0f;
 	res[3][2] = -(2.0f * far * near) / (far - near);
 	return res;
-}
\ No newline at end of file
+}
+
+// Minimum number of elements worth handing to a worker thread
+static constexpr size_t s_min_batch_per_thread = 16384;
+
+// Split [0, count) into contiguous chunks and run fun(begin, end) on up to `threads` threads
+template<class Fn>
+static void s_ParallelFor(size_t count, unsigned threads, Fn const& fun)
+{
+	// querying the cpu count is a system call on some platforms, do it once
+	static unsigned const hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+	if (threads == 0)
+		threads = hardware_threads;
+
+	size_t chunks = std::min<size_t>(threads, count / s_min_batch_per_thread);
+	if (chunks <= 1) {
+		fun(size_t(0), count);
+		return;
+	}
+
+	// keep chunk boundaries on full SIMD packs
+	size_t step = (count + chunks - 1) / chunks;
+	step = (step + SimdWidth - 1) / SimdWidth * SimdWidth;
+
+	std::vector<std::thread> workers;
+	workers.reserve(chunks - 1);
+	for (size_t begin = step; begin < count; begin += step)
+		workers.emplace_back(fun, begin, std::min(begin + step, count));
+
+	fun(size_t(0), std::min(step, count));
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+// Upper 3x4 part of a matrix broadcast into packs, one member per entry
+template<class Pack>
+struct TransformMatrixPacks
+{
+	Pack m00, m01, m02, m10, m11, m12, m20, m21, m22, m30, m31, m32;
+
+	explicit TransformMatrixPacks(Fmat4 const& mat)
+		: m00(SimdSet1<Pack>(mat[0].x)), m01(SimdSet1<Pack>(mat[0].y)), m02(SimdSet1<Pack>(mat[0].z)),
+		  m10(SimdSet1<Pack>(mat[1].x)), m11(SimdSet1<Pack>(mat[1].y)), m12(SimdSet1<Pack>(mat[1].z)),
+		  m20(SimdSet1<Pack>(mat[2].x)), m21(SimdSet1<Pack>(mat[2].y)), m22(SimdSet1<Pack>(mat[2].z)),
+		  m30(SimdSet1<Pack>(mat[3].x)), m31(SimdSet1<Pack>(mat[3].y)), m32(SimdSet1<Pack>(mat[3].z))
+	{
+	}
+
+	// Same accumulation order as Fmat4 * Fvec4, so results match the per-element path
+	template<bool Point>
+	void Apply(Pack x, Pack y, Pack z, Pack& rx, Pack& ry, Pack& rz) const
+	{
+		rx = SimdAdd(SimdAdd(SimdMul(m00, x), SimdMul(m10, y)), SimdMul(m20, z));
+		ry = SimdAdd(SimdAdd(SimdMul(m01, x), SimdMul(m11, y)), SimdMul(m21, z));
+		rz = SimdAdd(SimdAdd(SimdMul(m02, x), SimdMul(m12, y)), SimdMul(m22, z));
+		if constexpr (Point) {
+			rx = SimdAdd(rx, m30);
+			ry = SimdAdd(ry, m31);
+			rz = SimdAdd(rz, m32);
+		}
+	}
+};
+
+template<class Pack, bool Point>
+static size_t s_TransformSoA(Fmat4 const& mat, float const* const* in, float* const* out, size_t begin, size_t end)
+{
+	constexpr unsigned lanes = SimdLanes<Pack>;
+	TransformMatrixPacks<Pack> const packs(mat);
+
+	float const* x = in[0];
+	float const* y = in[1];
+	float const* z = in[2];
+	float* out_x = out[0];
+	float* out_y = out[1];
+	float* out_z = out[2];
+
+	size_t i = begin;
+	for (; i + lanes <= end; i += lanes)
+	{
+		Pack rx, ry, rz;
+		packs.template Apply<Point>(SimdLoad<Pack>(x + i), SimdLoad<Pack>(y + i), SimdLoad<Pack>(z + i), rx, ry, rz);
+		SimdStore(out_x + i, rx);
+		SimdStore(out_y + i, ry);
+		SimdStore(out_z + i, rz);
+	}
+	return i;
+}
+
+template<bool Point>
+static void s_TransformAoS(Fmat4 const& mat, Fvec3 const* in, Fvec3* out, size_t begin, size_t end)
+{
+	static_assert(sizeof(Fvec3) == 3 * sizeof(float));
+	size_t i = begin;
+
+#if defined(MATH_SIMD_SSE)
+
+	TransformMatrixPacks<SimdFloat4> const packs(mat);
+
+	// 4 points (12 floats) per iteration, transposed to x, y, z registers and back
+	for (; i + 4 <= end; i += 4)
+	{
+		float const* src = &in[i].x;
+		__m128 a = _mm_loadu_ps(src), b = _mm_loadu_ps(src + 4), c = _mm_loadu_ps(src + 8);
+
+		__m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		__m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 0, 1)),
+			_mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 1, 0, 2)),
+			_mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+		SimdFloat4 rx, ry, rz;
+		packs.template Apply<Point>({ x }, { y }, { z }, rx, ry, rz);
+		__m128 r[3] = { rx.Reg, ry.Reg, rz.Reg };
+
+		float* dst = &out[i].x;
+		_mm_storeu_ps(dst, _mm_shuffle_ps(_mm_shuffle_ps(r[0], r[1], _MM_SHUFFLE(0, 0, 1, 0)),
+			_mm_shuffle_ps(r[2], r[0], _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(dst + 4, _mm_shuffle_ps(_mm_shuffle_ps(r[1], r[2], _MM_SHUFFLE(1, 1, 1, 1)),
+			_mm_shuffle_ps(r[0], r[1], _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(dst + 8, _mm_shuffle_ps(_mm_shuffle_ps(r[2], r[0], _MM_SHUFFLE(3, 3, 2, 2)),
+			_mm_shuffle_ps(r[1], r[2], _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+
+#endif
+
+	TransformMatrixPacks<float> const scalar(mat);
+	for (; i < end; i++)
+	{
+		float rx, ry, rz;
+		scalar.template Apply<Point>(in[i].x, in[i].y, in[i].z, rx, ry, rz);
+		out[i] = Fvec3(rx, ry, rz);
+	}
+}
+
+template<bool Point>
+static void s_TransformAoSBatch(Fmat4 const& mat, std::span<Fvec3 const> in, std::span<Fvec3> out, unsigned threads)
+{
+	ERRCHECK(out.size() >= in.size());
+	s_ParallelFor(in.size(), threads, [&](size_t begin, size_t end) {
+		s_TransformAoS<Point>(mat, in.data(), out.data(), begin, end);
+	});
+}
+
+template<bool Point>
+static void s_TransformSoABatch(Fmat4 const& mat,
+	std::span<float const> x, std::span<float const> y, std::span<float const> z,
+	std::span<float> out_x, std::span<float> out_y, std::span<float> out_z, unsigned threads)
+{
+	size_t count = x.size();
+	ERRCHECK(y.size() == count && z.size() == count
+		&& out_x.size() >= count && out_y.size() >= count && out_z.size() >= count);
+
+	float const* in[3] = { x.data(), y.data(), z.data() };
+	float* out[3] = { out_x.data(), out_y.data(), out_z.data() };
+
+	s_ParallelFor(count, threads, [&](size_t begin, size_t end) {
+		size_t i = s_TransformSoA<SimdFloat, Point>(mat, in, out, begin, end);
+		s_TransformSoA<float, Point>(mat, in, out, i, end);
+	});
+}
+
+void TransformPoints(Fmat4 const& mat, std::span<Fvec3 const> in, std::span<Fvec3> out, unsigned threads)
+{
+	s_TransformAoSBatch<true>(mat, in, out, threads);
+}
+
+void TransformDirections(Fmat4 const& mat, std::span<Fvec3 const> in, std::span<Fvec3> out, unsigned threads)
+{
+	s_TransformAoSBatch<false>(mat, in, out, threads);
+}
+
+void TransformPoints(Fmat4 const& mat,
+	std::span<float const> x, std::span<float const> y, std::span<float const> z,
+	std::span<float> out_x, std::span<float> out_y, std::span<float> out_z, unsigned threads)
+{
+	s_TransformSoABatch<true>(mat, x, y, z, out_x, out_y, out_z, threads);
+}
+
+void TransformDirections(Fmat4 const& mat,
+	std::span<float const> x, std::span<float const> y, std::span<float const> z,
+	std::span<float> out_x, std::span<float> out_y, std::span<float> out_z, unsigned threads)
+{
+	s_TransformSoABatch<false>(mat, x, y, z, out_x, out_y, out_z, threads);
+}
+
+void TransformPoints(Fmat4 const& mat, Fvec3Array const& in, Fvec3Array& out, unsigned threads)
+{
+	out.Resize(in.Size());
+	s_TransformSoABatch<true>(mat, in.Lane(0), in.Lane(1), in.Lane(2), out.Lane(0), out.Lane(1), out.Lane(2), threads);
+}
+
+void TransformDirections(Fmat4 const& mat, Fvec3Array const& in, Fvec3Array& out, unsigned threads)
+{
+	out.Resize(in.Size());
+	s_TransformSoABatch<false>(mat, in.Lane(0), in.Lane(1), in.Lane(2), out.Lane(0), out.Lane(1), out.Lane(2), threads);
+}
+
+void ComposeModel(std::span<Fvec3 const> translations, std::span<Fmat3 const> rotations,
+	std::span<Fvec3 const> scales, std::span<Fmat4> out, unsigned threads)
+{
+	size_t count = translations.size();
+	ERRCHECK(rotations.size() == count && scales.size() == count && out.size() >= count);
+	s_ParallelFor(count, threads, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			s_ComposeModel(out[i], translations[i], rotations[i][0], rotations[i][1], rotations[i][2], scales[i]);
+	});
+}
+
+void ComposeModel(std::span<Fvec3 const> translations, std::span<Fquat const> rotations,
+	std::span<Fvec3 const> scales, std::span<Fmat4> out, unsigned threads)
+{
+	size_t count = translations.size();
+	ERRCHECK(rotations.size() == count && scales.size() == count && out.size() >= count);
+	s_ParallelFor(count, threads, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+			s_ComposeModel(out[i], translations[i], rotations[i], scales[i]);
+	});
+}
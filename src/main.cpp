@@ -4,6 +4,8 @@
 #include "Graphics/Pipeline.hpp"
 #include "Graphics/Sync.hpp"
 #include "Graphics/Buffer.hpp"
+#include "Graphics/PipelineCache.hpp"
+#include "Graphics/ShaderArchive.hpp"
 #include "Math/Vector.hpp"
 #include "Math/Matrix.hpp"
 #include "Math/Transform.hpp"
@@ -29,6 +31,27 @@ static void EventCallback(WindowEvent const& e)
     }
 }
 
+// Build count variants of info through a compiler with thread_count threads, returns the wall time in ms.
+// Each variant gets its own value of fragment constant 0 starting at first_constant, so no two variants,
+// in this batch or an earlier one, share specialization data.
+static double TimePipelineBatch(GraphicsPipeline::CreateInfo const& info, uint32_t count, uint32_t first_constant,
+                                uint32_t thread_count)
+{
+    std::vector<GraphicsPipeline::CreateInfo> infos(count, info);
+    for (uint32_t i = 0; i < count; i++)
+        infos[i].FragmentConstants.Set(0, first_constant + i);
+
+    // threads are started before the clock, the pipelines are destroyed after it
+    PipelineCompiler compiler(thread_count);
+    std::vector<std::unique_ptr<GraphicsPipeline>> pipelines;
+    pipelines.reserve(count);
+
+    auto begin = std::chrono::steady_clock::now();
+    for (auto& future : compiler.Submit(infos))
+        pipelines.push_back(future.get());
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
 int main(int argc, char** argv)
 {
     GraphicsAPI api;
@@ -37,17 +60,34 @@ int main(int argc, char** argv)
 
     GraphicsDevice device(api, window);
 
+    device.GetShaderLibrary().Mount("out/shaders/shaders.spva");
+
     GraphicsPipeline::CreateInfo info;
     info.Device = &device;
-    info.Vertex = "out/shaders/shader.vert.spv";
-    info.Fragment = "out/shaders/shader.frag.spv";
+    info.Vertex = "shader.vert";
+    info.Fragment = "shader.frag";
     info.Input.Add(0, 3);
     info.Input.Add(1, 3);
-	info.Descriptors[0].AddUniformBuffer(0, VK_SHADER_STAGE_VERTEX_BIT);
-	info.DescriptorSetsMultiplier = 2;
+	info.Descriptors[0].AddDynamicUniformBuffer(0, VK_SHADER_STAGE_VERTEX_BIT);
 
     GraphicsPipeline pipeline(info);
 
+    // compare a first (cold) run against later (warm) runs
+    PipelineCacheStats cache_stats = device.GetPipelineCache().GetStats();
+    std::cout << "Pipeline cache: " << cache_stats.LoadedBytes << " bytes loaded, " << cache_stats.PipelineCount
+              << " pipelines in " << cache_stats.CreateMilliseconds << " ms, " << cache_stats.HitCount << " cache hits\n";
+
+    // --pipeline-batch [count]: spec constant variants on one compiler thread, then on one per hardware
+    // thread. Wall time, the cache stats sum the time of all threads.
+    if (argc > 1 && std::string_view(argv[1]) == "--pipeline-batch") {
+        uint32_t count = argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 64;
+        uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        double serial_ms = TimePipelineBatch(info, count, 0, 1);
+        double parallel_ms = TimePipelineBatch(info, count, count, threads);
+        std::cout << "Pipeline batch: " << count << " pipelines, 1 thread " << serial_ms << " ms, " << threads
+                  << " threads " << parallel_ms << " ms, x" << serial_ms / parallel_ms << '\n';
+    }
+
     std::array vertices = {
         Vertex{Fvec3(-0.5f, 0.5f, 0.0f), Fvec3(1.0f, 0.0f, 0.0f)},
         Vertex{Fvec3(0.5f, 0.5f, 0.0f), Fvec3(0.0f, 1.0f, 0.0f)},
@@ -60,10 +100,9 @@ int main(int argc, char** argv)
         0, 2, 3
     };
 
-	UniformBuffer uniforms[2] = {UniformBuffer(device, sizeof(MVP_Matrix)), UniformBuffer(device, sizeof(MVP_Matrix))};
+	UniformRing uniforms(device, 64 << 10, 2);
 
-	pipeline.WriteDescriptor(0, 0, uniforms[0].GetBuffer(), uniforms[0].GetSize());
-	pipeline.WriteDescriptor(0, 1, uniforms[1].GetBuffer(), uniforms[1].GetSize());
+	pipeline.WriteDescriptor(0, 0, uniforms.GetBuffer(), sizeof(MVP_Matrix));
 	
     VkCommandBuffer cmd[2];
     device.CreateDrawCmdBuffers(cmd, 2);
@@ -71,7 +110,7 @@ int main(int argc, char** argv)
     VertexBuffer vb(device, sizeof(Vertex) * vertices.size());
     vb.MapData(vertices.data());
 
-    IndexBuffer ib(device, sizeof(unsigned) * indices.size());
+    IndexBuffer ib(device, indices.size(), vertices.size());
     ib.MapData(indices.data());
 
     uint32_t frame = 0;
@@ -87,11 +126,12 @@ int main(int argc, char** argv)
 		mvp.model = RotateModel(glfwGetTime(), Fvec3(0.f, 1.f, 0.f));
 		mvp.view = LookAtView(Fvec3(0.f, 0.f, 1.f), Fvec3(0.f, 0.f, -1.f));
 		mvp.proj = PerspectiveProjection(2.0944f, 16.f/9, .1f, 100.f);
-		uniforms[frame].Update(&mvp);
+		uniforms.BeginFrame(frame);
+		uint32_t mvp_offset = uniforms.Push(mvp);
 
         DrawCmdRecorder rec = device.BeginRecord(cmd[frame], index);
         rec.BindPipeline(pipeline);
-		rec.BindDescriptorSets(pipeline, frame);
+		rec.BindDescriptorSets(pipeline, 0, { &mvp_offset, 1 });
         rec.SetViewportDefault();
         rec.SetScissorDefault();
         rec.BindVertexBuffer(vb);
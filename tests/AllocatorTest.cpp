@@ -0,0 +1,240 @@
+#include "Graphics/Allocator.hpp"
+
+// Allocator tests, run headless.
+//
+//   allocator_test [buddy | device]
+//
+// buddy checks BuddyAllocator alone and needs no Vulkan device. device is a smoke run of DeviceAllocator
+// on the first software device, or the first device when there is none. Select lavapipe with
+// VK_ICD_FILENAMES=<path>/lvp_icd.x86_64.json. Without any device it exits with s_skip_code.
+// Without an argument both run. Returns non-zero when a check fails.
+
+// Exit code of a skipped run, the ctest SKIP_RETURN_CODE
+static constexpr int s_skip_code = 77;
+
+static size_t s_failures = 0;
+
+static void s_Check(bool ok, char const* what, int line)
+{
+    if (!ok) {
+        std::printf("FAILED line %d: %s\n", line, what);
+        ++s_failures;
+    }
+}
+
+#define CHECK(...) s_Check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __LINE__)
+
+static void s_TestBuddySplitMerge()
+{
+    BuddyAllocator buddy(1024, 64);
+
+    // the first range splits 1024 down to 64, the upper halves are handed out next
+    CHECK(buddy.Allocate(64, 1) == 0);
+    CHECK(buddy.Allocate(64, 1) == 64);
+    CHECK(buddy.Allocate(128, 1) == 128);
+    CHECK(buddy.Allocate(256, 1) == 256);
+    CHECK(buddy.GetFreeBytes() == 512 && buddy.GetLargestFreeRange() == 512);
+    CHECK(buddy.Allocate(512, 1) == 512);
+    CHECK(buddy.GetFreeBytes() == 0 && buddy.GetLargestFreeRange() == 0);
+    CHECK(!buddy.Allocate(64, 1));
+
+    // a free 64 byte range does not serve 128 bytes, there is no larger order to split
+    buddy.Free(64);
+    CHECK(!buddy.Allocate(128, 1));
+    CHECK(buddy.Allocate(64, 1) == 64);
+
+    // freed in any order, buddies merge back into the whole range
+    for (VkDeviceSize offset : { 256, 0, 512, 64, 128 })
+        buddy.Free(offset);
+    CHECK(buddy.IsEmpty());
+    CHECK(buddy.GetFreeBytes() == 1024 && buddy.GetLargestFreeRange() == 1024);
+    CHECK(buddy.Allocate(1024, 1) == 0);
+}
+
+static void s_TestBuddyAlignment()
+{
+    BuddyAllocator buddy(4096, 64);
+
+    // sizes round up to min_size and then to a power of two
+    CHECK(buddy.Allocate(1, 1) == 0);
+    CHECK(buddy.GetFreeBytes() == 4096 - 64);
+    CHECK(buddy.Allocate(100, 1) == 128);
+
+    // alignment above the size takes a range of the alignment
+    auto aligned = buddy.Allocate(64, 1024);
+    CHECK(aligned && *aligned % 1024 == 0);
+    CHECK(buddy.Allocate(300, 256) == 512);
+    CHECK(buddy.GetFreeBytes() == 4096 - 64 - 128 - 1024 - 512);
+
+    for (VkDeviceSize offset : { VkDeviceSize(0), VkDeviceSize(128), *aligned, VkDeviceSize(512) })
+        buddy.Free(offset);
+    CHECK(buddy.IsEmpty() && buddy.GetLargestFreeRange() == 4096);
+}
+
+static void s_TestBuddyOutOfMemory()
+{
+    BuddyAllocator buddy(1024, 64);
+    CHECK(!buddy.Allocate(2048, 1));
+    CHECK(!buddy.Allocate(64, 2048));
+    CHECK(buddy.IsEmpty() && buddy.GetFreeBytes() == 1024);
+
+    // releasing an offset that was never handed out is an error
+    bool threw = false;
+    try {
+        buddy.Free(0);
+    }
+    catch (std::runtime_error const&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+static void s_TestDeviceAllocator(VkPhysicalDevice physical_device, VkDevice device)
+{
+    constexpr VkMemoryPropertyFlags host_flags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    constexpr VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+
+    // small blocks so a few dozen buffers span several of them
+    DeviceAllocator allocator(physical_device, device, VkDeviceSize(64) << 10);
+
+    std::vector<std::pair<VkBuffer, MemoryAllocation>> buffers;
+    for (unsigned i = 0; i < 64; i++)
+        buffers.push_back(allocator.CreateBuffer(1000 + i * 40, usage, host_flags));
+
+    AllocatorStats stats = allocator.GetStats();
+    CHECK(stats.AllocationCount == 64);
+    CHECK(stats.DeviceMemoryCount > 1 && stats.DeviceMemoryCount < 64);
+    CHECK(stats.RequestedBytes < stats.ReservedBytes);
+
+    // bound at aligned offsets, mapped, and no two ranges overlap
+    for (unsigned i = 0; i < buffers.size(); i++)
+    {
+        auto const& [buffer, allocation] = buffers[i];
+        VkMemoryRequirements req;
+        vkGetBufferMemoryRequirements(device, buffer, &req);
+        CHECK(allocation.Offset % req.alignment == 0 && allocation.Size == req.size);
+        CHECK(allocation.Mapped != nullptr);
+        if (allocation.Mapped)
+            std::memset(allocation.Mapped, static_cast<int>(i), allocation.Size);
+    }
+    for (unsigned i = 0; i < buffers.size(); i++)
+    {
+        auto const& allocation = buffers[i].second;
+        auto bytes = static_cast<unsigned char const*>(allocation.Mapped);
+        CHECK(bytes && std::all_of(bytes, bytes + allocation.Size, [i](unsigned char b) { return b == i; }));
+    }
+
+    // larger than half a block gets its own memory
+    auto dedicated = allocator.CreateBuffer(VkDeviceSize(64) << 10, usage, host_flags);
+    CHECK(dedicated.second.Dedicated && dedicated.second.Mapped);
+
+    auto device_buffer = allocator.CreateDeviceBuffer(4096, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+    CHECK(device_buffer.second.Memory != VK_NULL_HANDLE);
+    CHECK(allocator.GetMemoryProperties().memoryTypes[device_buffer.second.MemoryType].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // free every other buffer, then the rest
+    for (unsigned i = 0; i < buffers.size(); i += 2)
+        allocator.DestroyBuffer(buffers[i].first, buffers[i].second);
+    CHECK(allocator.GetStats().AllocationCount == 32 + 2);
+    for (unsigned i = 1; i < buffers.size(); i += 2)
+        allocator.DestroyBuffer(buffers[i].first, buffers[i].second);
+    allocator.DestroyBuffer(dedicated.first, dedicated.second);
+    allocator.DestroyBuffer(device_buffer.first, device_buffer.second);
+
+    // one block per used memory type is kept, each is a single free range again
+    stats = allocator.GetStats();
+    CHECK(stats.AllocationCount == 0 && stats.RequestedBytes == 0);
+    CHECK(stats.DeviceMemoryCount <= 2 && stats.FreeBytes == stats.ReservedBytes);
+    CHECK(stats.Fragmentation() == 0.0f);
+}
+
+// Returns false when there is no device to run on
+static bool s_RunDevice()
+{
+    VkApplicationInfo app_i{};
+    app_i.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app_i.pApplicationName = "allocator_test";
+    app_i.apiVersion = VK_API_VERSION_1_0;
+
+    VkInstanceCreateInfo instance_ci{};
+    instance_ci.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instance_ci.pApplicationInfo = &app_i;
+
+    VkInstance instance;
+    if (vkCreateInstance(&instance_ci, nullptr, &instance) != VK_SUCCESS)
+        return false;
+
+    uint32_t count = 0;
+    vkEnumeratePhysicalDevices(instance, &count, nullptr);
+    std::vector<VkPhysicalDevice> physical_devices(count);
+    vkEnumeratePhysicalDevices(instance, &count, physical_devices.data());
+    if (physical_devices.empty()) {
+        vkDestroyInstance(instance, nullptr);
+        return false;
+    }
+
+    // software rasterizers like lavapipe report a CPU device, they give the same result everywhere
+    VkPhysicalDevice physical_device = physical_devices[0];
+    VkPhysicalDeviceProperties properties;
+    for (auto candidate : physical_devices) {
+        vkGetPhysicalDeviceProperties(candidate, &properties);
+        if (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+            physical_device = candidate;
+            break;
+        }
+    }
+    vkGetPhysicalDeviceProperties(physical_device, &properties);
+    std::printf("Device: %s\n", properties.deviceName);
+
+    // memory only, one queue of family 0 is enough
+    float priority = 1.0f;
+    VkDeviceQueueCreateInfo queue_ci{};
+    queue_ci.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queue_ci.queueFamilyIndex = 0;
+    queue_ci.queueCount = 1;
+    queue_ci.pQueuePriorities = &priority;
+
+    VkDeviceCreateInfo device_ci{};
+    device_ci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    device_ci.queueCreateInfoCount = 1;
+    device_ci.pQueueCreateInfos = &queue_ci;
+
+    VkDevice device;
+    bool created = vkCreateDevice(physical_device, &device_ci, nullptr, &device) == VK_SUCCESS;
+    CHECK(created);
+    if (created) {
+        try {
+            s_TestDeviceAllocator(physical_device, device);
+        }
+        catch (std::exception const& e) {
+            std::printf("FAILED: %s\n", e.what());
+            ++s_failures;
+        }
+        vkDestroyDevice(device, nullptr);
+    }
+
+    vkDestroyInstance(instance, nullptr);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string mode = argc > 1 ? argv[1] : "";
+    bool skipped = false;
+
+    if (mode.empty() || mode == "buddy") {
+        s_TestBuddySplitMerge();
+        s_TestBuddyAlignment();
+        s_TestBuddyOutOfMemory();
+    }
+    if (mode.empty() || mode == "device") {
+        skipped = !s_RunDevice();
+        if (skipped)
+            std::printf("No Vulkan device, DeviceAllocator smoke run skipped\n");
+    }
+
+    std::printf("Failures: %zu\n", s_failures);
+    if (s_failures)
+        return 1;
+    return skipped && mode == "device" ? s_skip_code : 0;
+}
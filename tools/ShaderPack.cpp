@@ -0,0 +1,86 @@
+#include "Graphics/ShaderArchiveFormat.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Packs compiled shaders into one archive loaded by ShaderArchive.
+//
+//   shader_pack <output> <shader.spv>...
+//
+// Each shader is named by its file name without the .spv extension, e.g. shader.vert.spv is "shader.vert".
+
+static bool s_ReadFile(std::filesystem::path const& path, std::vector<char>& data)
+{
+    std::ifstream ifs(path, std::ios::ate | std::ios::binary);
+    if (!ifs.is_open())
+        return false;
+    data.resize(static_cast<size_t>(ifs.tellg()));
+    ifs.seekg(0);
+    ifs.read(data.data(), static_cast<std::streamsize>(data.size()));
+    return ifs.good();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "usage: shader_pack <output> <shader.spv>...\n";
+        return 1;
+    }
+
+    uint32_t count = static_cast<uint32_t>(argc - 2);
+    std::vector<ShaderArchiveEntry> entries(count);
+    std::vector<std::vector<char>> blobs(count);
+
+    auto align = [](uint64_t offset) { return (offset + SHADER_ARCHIVE_ALIGNMENT - 1) & ~(SHADER_ARCHIVE_ALIGNMENT - 1); };
+    uint64_t offset = align(sizeof(ShaderArchiveHeader) + count * sizeof(ShaderArchiveEntry));
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        std::filesystem::path path = argv[i + 2];
+        std::string name = path.filename().string();
+        if (name.ends_with(".spv"))
+            name.resize(name.size() - 4);
+
+        if (name.size() >= sizeof(ShaderArchiveEntry::Name)) {
+            std::cerr << "shader_pack: name too long: " << name << '\n';
+            return 1;
+        }
+        for (uint32_t j = 0; j < i; j++) {
+            if (name == entries[j].Name) {
+                std::cerr << "shader_pack: duplicate shader " << name << '\n';
+                return 1;
+            }
+        }
+        if (!s_ReadFile(path, blobs[i]) || blobs[i].empty() || blobs[i].size() % 4) {
+            std::cerr << "shader_pack: cannot read SPIR-V from " << path.string() << '\n';
+            return 1;
+        }
+
+        std::memcpy(entries[i].Name, name.c_str(), name.size() + 1);
+        entries[i].Offset = offset;
+        entries[i].Size = blobs[i].size();
+        offset = align(offset + blobs[i].size());
+    }
+
+    ShaderArchiveHeader header{};
+    std::memcpy(header.Magic, SHADER_ARCHIVE_MAGIC, sizeof(header.Magic));
+    header.Version = SHADER_ARCHIVE_VERSION;
+    header.Count = count;
+
+    std::vector<char> archive(offset);
+    std::memcpy(archive.data(), &header, sizeof(header));
+    std::memcpy(archive.data() + sizeof(header), entries.data(), count * sizeof(ShaderArchiveEntry));
+    for (uint32_t i = 0; i < count; i++)
+        std::memcpy(archive.data() + entries[i].Offset, blobs[i].data(), blobs[i].size());
+
+    std::ofstream ofs(argv[1], std::ios::binary | std::ios::trunc);
+    ofs.write(archive.data(), static_cast<std::streamsize>(archive.size()));
+    if (!ofs.good()) {
+        std::cerr << "shader_pack: cannot write " << argv[1] << '\n';
+        return 1;
+    }
+    return 0;
+}